@@ -0,0 +1,863 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// reader benchmark: generates synthetic files of all supported formats, times OctFileRead::openFile and
+// OctFileRead::writeFile and writes the results as json,
+// the series build of 1024 B-scans with the incremental convex hull is compared with a hull rebuilt after every insert,
+// the B-scan allocation (BlockPool against the heap) and the memory over repeated open/close cycles are measured too,
+// the vol intensity kernel (volGrayTransform) is compared with the OpenCV three pass conversion on 1024x496 B-scans
+//
+// usage: octdata_bench [--dir fixtures] [--out bench.json] [--width 512] [--height 496] [--bscans 49] [--repeat 5] [--cycles 20]
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/endian/conversion.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/geometry.hpp>
+#include <boost/geometry/geometries/polygon.hpp>
+#include <boost/geometry/geometries/point_xy.hpp>
+
+#include <opencv2/opencv.hpp>
+
+#ifdef __unix__
+	#include <sys/resource.h>
+	#include <unistd.h>
+#endif
+
+#ifdef TIFFSTACK_SUPPORT
+	#include <tiffio.h>
+#endif
+
+#include <octfileread.h>
+#include <filereadoptions.h>
+#include <filewriteoptions.h>
+#include <datastruct/oct.h>
+#include <datastruct/bscan.h>
+#include <datastruct/sloimage.h>
+#include <datastruct/series.h>
+#include <import/he_vol/vol_gray_transform.h>
+
+namespace bfs = boost::filesystem;
+
+namespace
+{
+	struct BenchConfig
+	{
+		bfs::path   fixtureDir  = "octdata_bench_fixtures";
+		bfs::path   outFile     = "octdata_bench.json";
+		std::size_t width       = 512;     // A-scans per B-scan
+		std::size_t height      = 496;     // pixels per A-scan
+		std::size_t numBScans   = 49;
+		std::size_t sloSize     = 768;
+		std::size_t repeat      = 5;
+		std::size_t cycles      = 20;      // open/close cycles for the memory growth
+		std::size_t allocBScans = 50000;   // B-scans per allocation run
+		std::size_t hullBScans  = 1024;    // B-scans per series for the incremental against the rebuilt hull
+	};
+
+	typedef boost::geometry::model::d2::point_xy<double> HullPoint;
+	typedef boost::geometry::model::polygon<HullPoint>   HullPolygon;
+
+	struct TimingStats
+	{
+		std::vector<double> seconds;
+
+		double percentile(double p) const
+		{
+			if(seconds.empty())
+				return 0;
+			std::vector<double> sorted = seconds;
+			std::sort(sorted.begin(), sorted.end());
+			const std::size_t rank = static_cast<std::size_t>(p*static_cast<double>(sorted.size() - 1) + 0.5);
+			return sorted[std::min(rank, sorted.size() - 1)];
+		}
+	};
+
+	struct FormatResult
+	{
+		std::string name;
+		bfs::path   file;
+		std::size_t fileBytes   = 0;
+		std::size_t bscansRead  = 0;
+		bool        ok          = false;
+		bool        hasWrite    = false;
+		TimingStats open;
+		TimingStats destroy;
+		TimingStats write;
+		long        peakRssKB   = 0;
+		std::string error;
+	};
+
+	// series of hullBScans B-scans: takeBScan with the incremental hull against the hull rebuilt from all points per insert
+	struct SeriesBuildResult
+	{
+		TimingStats incremental;
+		TimingStats rebuild;
+		double      incrementalArea = 0;                       // area of the final hulls, equal if both hulls agree
+		double      rebuildArea     = 0;
+	};
+
+	// allocate and free runs of metadata only B-scans, the class operator new (BlockPool) against the global heap
+	struct AllocResult
+	{
+		TimingStats pool;
+		TimingStats heap;
+	};
+
+	// vol float pixels to 8 bit: volGrayTransform against threshold (THRESH_TRUNC) + pow(0.25) + convertTo(CV_8U, 255)
+	struct KernelResult
+	{
+		std::string instructionSet;
+		TimingStats fused;
+		TimingStats threePass;
+		std::size_t mismatches = 0;                            // pixels with different results
+	};
+
+	// the same file opened and closed repeatedly, a resident set growing over the cycles shows heap fragmentation
+	struct CycleResult
+	{
+		std::string format;
+		TimingStats open;
+		TimingStats destroy;
+		long        rssFirstKB = 0;                            // after the first close
+		long        rssLastKB  = 0;                            // after the last close
+		long        peakRssKB  = 0;
+	};
+
+	long peakRssKB()
+	{
+#ifdef __unix__
+		rusage usage;
+		if(getrusage(RUSAGE_SELF, &usage) == 0)
+			return usage.ru_maxrss;
+#endif
+		return 0;
+	}
+
+	long currentRssKB()
+	{
+#ifdef __linux__
+		std::ifstream statm("/proc/self/statm");
+		long pages    = 0;
+		long resident = 0;
+		if(statm >> pages >> resident)
+			return resident*(sysconf(_SC_PAGESIZE)/1024);
+#endif
+		return 0;
+	}
+
+	template<typename F>
+	double measureSeconds(F f)
+	{
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		f();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	std::size_t countBScans(const OctData::OCT& oct)
+	{
+		std::size_t num = 0;
+		for(const OctData::OCT::SubstructurePair& pat : oct)
+			for(const OctData::Patient::SubstructurePair& study : *pat.second)
+				for(const OctData::Study::SubstructurePair& series : *study.second)
+					num += series.second->bscanCount();
+		return num;
+	}
+
+
+	// --- synthetic data ---
+
+	// retina like layer structure with speckle noise, reproducible by the fixed seed
+	cv::Mat createBScanImage(const BenchConfig& cfg, std::size_t num)
+	{
+		cv::Mat image(static_cast<int>(cfg.height), static_cast<int>(cfg.width), cv::DataType<uint8_t>::type);
+		cv::RNG rng(static_cast<uint64_t>(1000 + num));
+		rng.fill(image, cv::RNG::UNIFORM, 0, 40);
+
+		const int rows = image.rows;
+		for(int c = 0; c < image.cols; ++c)
+		{
+			const int surface = rows/3 + static_cast<int>(static_cast<double>(rows)/20.*std::sin(static_cast<double>(c + static_cast<int>(num))*0.02));
+			for(int r = std::max(surface, 0); r < std::min(surface + rows/4, rows); ++r)
+				image.at<uint8_t>(r, c) = static_cast<uint8_t>(std::min(255, image.at<uint8_t>(r, c) + 120 + (r - surface)/2));
+		}
+		return image;
+	}
+
+	void createSyntheticOCT(const BenchConfig& cfg, OctData::OCT& oct)
+	{
+		OctData::Patient& pat    = oct.getPatient(1);
+		OctData::Study&   study  = pat.getStudy(1);
+		OctData::Series&  series = study.getSeries(1);
+
+		pat.setId("BENCH0001");
+		study.setStudyDate(OctData::Date::fromDate(2020, 1, 1));
+		series.setLaterality(OctData::Series::Laterality::OD);
+		series.setScanPattern(OctData::Series::ScanPattern::Volume);
+		series.setExaminedStructure(OctData::Series::ExaminedStructure::Retina);
+		series.setSeriesUID("bench.series.1");
+
+		cv::Mat sloImage(static_cast<int>(cfg.sloSize), static_cast<int>(cfg.sloSize), cv::DataType<uint8_t>::type);
+		cv::RNG rng(1);
+		rng.fill(sloImage, cv::RNG::UNIFORM, 0, 255);
+		OctData::SloImage* slo = new OctData::SloImage;
+		slo->setImage(sloImage);
+		slo->setScaleFactor(OctData::ScaleFactor(0.0114, 0.0114));
+		series.takeSloImage(slo);
+
+		const double sizeMM = 6.;
+		for(std::size_t i = 0; i < cfg.numBScans; ++i)
+		{
+			const double y = sizeMM*static_cast<double>(i)/static_cast<double>(std::max<std::size_t>(cfg.numBScans - 1, 1));
+
+			OctData::BScan::Data data;
+			data.start       = OctData::CoordSLOmm(1.  , 1. + y);
+			data.end         = OctData::CoordSLOmm(7.  , 1. + y);
+			data.scaleFactor = OctData::ScaleFactor(sizeMM/static_cast<double>(cfg.width), 0.25, 0.0039);
+			series.takeBScan(new OctData::BScan(createBScanImage(cfg, i), data));
+		}
+	}
+
+
+	// B-scan i of a 6x6 mm raster volume with num B-scans
+	OctData::BScan::Data rasterBScanData(std::size_t i, std::size_t num)
+	{
+		const double y = 6.*static_cast<double>(i)/static_cast<double>(std::max<std::size_t>(num - 1, 1));
+
+		OctData::BScan::Data data;
+		data.start = OctData::CoordSLOmm(1., 1. + y);
+		data.end   = OctData::CoordSLOmm(7., 1. + y);
+		return data;
+	}
+
+	// metadata only series, measures the B-scan insertion (convex hull and corner coordinates)
+	double timeSeriesBuild(std::size_t numBScans, double* hullArea = nullptr)
+	{
+		OctData::Series series(1);
+		const double seconds = measureSeconds([&series, numBScans]()
+		{
+			for(std::size_t i = 0; i < numBScans; ++i)
+				series.takeBScan(new OctData::BScan(cv::Mat(), rasterBScanData(i, numBScans)));
+		});
+
+		if(hullArea)
+		{
+			HullPolygon hull;
+			for(const OctData::CoordSLOmm& pt : series.getConvexHull())
+				boost::geometry::append(hull, HullPoint(pt.getX(), pt.getY()));
+			*hullArea = boost::geometry::area(hull);
+		}
+		return seconds;
+	}
+
+	// reference for the incremental hull of Series::takeBScan: the hull of all B-scan points rebuilt after every insert
+	double timeHullRebuild(std::size_t numBScans, double* hullArea = nullptr)
+	{
+		HullPolygon hull;
+		const double seconds = measureSeconds([&hull, numBScans]()
+		{
+			HullPolygon points;
+			for(std::size_t i = 0; i < numBScans; ++i)
+			{
+				const OctData::BScan::Data data = rasterBScanData(i, numBScans);
+				boost::geometry::append(points, HullPoint(data.start.getX(), data.start.getY()));
+				boost::geometry::append(points, HullPoint(data.end  .getX(), data.end  .getY()));
+
+				hull.clear();
+				boost::geometry::convex_hull(points, hull);
+			}
+		});
+
+		if(hullArea)
+			*hullArea = boost::geometry::area(hull);
+		return seconds;
+	}
+
+
+	// vol reflectivity of a synthetic B-scan (inverse of the display transformation) with values over 1 and empty pixels
+	cv::Mat createVolPixels(std::size_t width, std::size_t height)
+	{
+		BenchConfig imageCfg;
+		imageCfg.width  = width;
+		imageCfg.height = height;
+
+		cv::Mat pixels;
+		createBScanImage(imageCfg, 0).convertTo(pixels, CV_32F, 1./255.);
+		cv::pow(pixels, 4., pixels);
+		for(int r = 0; r < pixels.rows; r += 7)
+			pixels.at<float>(r, r % pixels.cols) = 1.5f;
+		for(int r = 0; r < pixels.rows; ++r)
+			pixels.at<float>(r, 0) = pixels.at<float>(r, pixels.cols - 1) = 3.4e38f;  // empty border columns
+		return pixels;
+	}
+
+	void runVolGrayKernel(const BenchConfig& cfg, KernelResult& result)
+	{
+		const std::size_t kernelWidth  = 1024;
+		const std::size_t kernelHeight = 496;
+		const std::size_t kernelRepeat = 20*cfg.repeat;
+
+		result.instructionSet = OctData::volGrayTransformInstructionSet();
+
+		const cv::Mat pixels = createVolPixels(kernelWidth, kernelHeight);
+		cv::Mat fused(pixels.rows, pixels.cols, CV_8U);
+		cv::Mat clamped;
+		cv::Mat powImage;
+		cv::Mat threePass;
+		for(std::size_t i = 0; i < kernelRepeat; ++i)
+		{
+			result.fused.seconds.push_back(measureSeconds([&]()
+			{
+				for(int r = 0; r < pixels.rows; ++r)
+					OctData::volGrayTransform(pixels.ptr<float>(r), fused.ptr<uint8_t>(r), kernelWidth, true);
+			}));
+			result.threePass.seconds.push_back(measureSeconds([&]()
+			{
+				cv::threshold(pixels, clamped, 1.0, 1.0, cv::THRESH_TRUNC);
+				cv::pow(clamped, 0.25, powImage);
+				powImage.convertTo(threePass, CV_8U, 255, 0);
+			}));
+		}
+		result.mismatches = static_cast<std::size_t>(cv::countNonZero(fused != threePass));
+	}
+
+	// the B-scans are freed in two interleaved passes, like the B-scans of files closed in a different order than opened
+	double timeBScanAlloc(const BenchConfig& cfg, bool pooled)
+	{
+		std::vector<OctData::BScan*> bscans(cfg.allocBScans);
+		const OctData::BScan::Data data;
+		return measureSeconds([&]()
+		{
+			for(OctData::BScan*& bscan : bscans)
+				bscan = pooled ? new OctData::BScan(cv::Mat(), data) : ::new OctData::BScan(cv::Mat(), data);
+
+			for(std::size_t pass = 0; pass < 2; ++pass)
+				for(std::size_t i = pass; i < bscans.size(); i += 2)
+				{
+					if(pooled)
+						delete bscans[i];
+					else
+					{
+						bscans[i]->~BScan();
+						::operator delete(bscans[i]);
+					}
+				}
+		});
+	}
+
+
+	// --- writers for formats without export ---
+
+	template<typename T>
+	void writeRaw(std::ostream& stream, const T& value)
+	{
+		stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template<typename T>
+	void writeBig(std::ostream& stream, T value)
+	{
+		boost::endian::native_to_big_inplace(value);
+		writeRaw(stream, value);
+	}
+
+	void writeBig(std::ostream& stream, float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		writeBig(stream, bits);
+	}
+
+	void writeBig(std::ostream& stream, double value)
+	{
+		uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		writeBig(stream, bits);
+	}
+
+	void writePadded(std::ostream& stream, const std::string& str, std::size_t size)
+	{
+		std::vector<char> buffer(size, 0);
+		std::copy_n(str.begin(), std::min(str.size(), size), buffer.begin());
+		stream.write(buffer.data(), static_cast<std::streamsize>(size));
+	}
+
+	void fillTo(std::ostream& stream, std::streamoff pos)
+	{
+		const std::streamoff actPos = stream.tellp();
+		if(actPos < pos)
+			writePadded(stream, std::string(), static_cast<std::size_t>(pos - actPos));
+	}
+
+	// Heidelberg vol (little endian), B-scans as float reflectivity
+	bool writeVol(const bfs::path& file, const OctData::OCT& oct, const BenchConfig& cfg)
+	{
+		const std::size_t bscanHdrSize = 256;
+
+		std::ofstream stream(file.generic_string(), std::ios::binary);
+		stream.write("HSF-OCT-", 8);
+		writePadded(stream, "103", 4);
+		writeRaw(stream, static_cast<uint32_t>(cfg.width    ));
+		writeRaw(stream, static_cast<uint32_t>(cfg.numBScans));
+		writeRaw(stream, static_cast<uint32_t>(cfg.height   ));
+		writeRaw(stream, 6./static_cast<double>(cfg.width));      // scaleX
+		writeRaw(stream, 0.125);                                   // distance
+		writeRaw(stream, 0.0039);                                  // scaleZ
+		writeRaw(stream, static_cast<uint32_t>(cfg.sloSize));
+		writeRaw(stream, static_cast<uint32_t>(cfg.sloSize));
+		writeRaw(stream, 0.0114);                                  // scaleXSlo
+		writeRaw(stream, 0.0114);                                  // scaleYSlo
+		writeRaw(stream, static_cast<uint32_t>(30));               // fieldSizeSlo
+		writeRaw(stream, 0.);                                      // scanFocus
+		writePadded(stream, "OD", 4);
+		writeRaw(stream, static_cast<uint64_t>(0));                // examTime
+		writeRaw(stream, static_cast<uint32_t>(3));                // scanPattern: volume
+		writeRaw(stream, static_cast<uint32_t>(bscanHdrSize));
+		writePadded(stream, "bench.series.1", 16);
+		writePadded(stream, ""              , 16);
+		writeRaw(stream, static_cast<uint32_t>(1));                // pid
+		writePadded(stream, "BENCH0001", 21);
+		writePadded(stream, ""         ,  3);
+		writeRaw(stream, 0.);                                      // dob
+		writeRaw(stream, static_cast<uint32_t>(1));                // vid
+		writePadded(stream, "", 24);
+		writeRaw(stream, 0.);                                      // visitDate
+		writeRaw(stream, static_cast<int32_t>(0));                 // gridType
+		writeRaw(stream, static_cast<int32_t>(0));                 // gridOffset
+		fillTo(stream, 2048);
+
+		const OctData::Series& series = *oct.begin()->second->begin()->second->begin()->second;
+		const cv::Mat& sloImage = series.getSloImage().getImage();
+		stream.write(reinterpret_cast<const char*>(sloImage.data), static_cast<std::streamsize>(sloImage.total()));
+
+		cv::Mat floatImage;
+		for(const OctData::BScan* bscan : series.getBScans())
+		{
+			const std::streamoff bscanPos = stream.tellp();
+			stream.write("HSF-BS-", 7);
+			writePadded(stream, "103", 5);
+			writeRaw(stream, static_cast<uint32_t>(bscanHdrSize));
+			writeRaw(stream, bscan->getStart().getX());
+			writeRaw(stream, bscan->getStart().getY());
+			writeRaw(stream, bscan->getEnd  ().getX());
+			writeRaw(stream, bscan->getEnd  ().getY());
+			writeRaw(stream, static_cast<int32_t>(0));             // numSeg
+			writeRaw(stream, static_cast<int32_t>(bscanHdrSize));  // offSeg
+			writeRaw(stream, 30.f);                                // quality
+			writeRaw(stream, static_cast<int32_t>(0));             // shift
+			fillTo(stream, bscanPos + static_cast<std::streamoff>(bscanHdrSize));
+
+			// inverse of the display transformation (pow 0.25)
+			bscan->getImage().convertTo(floatImage, CV_32F, 1./255.);
+			cv::pow(floatImage, 4., floatImage);
+			stream.write(reinterpret_cast<const char*>(floatImage.data), static_cast<std::streamsize>(floatImage.total()*sizeof(float)));
+		}
+		return stream.good();
+	}
+
+	// gipl, 256 byte big endian header followed by the uint8 volume
+	bool writeGipl(const bfs::path& file, const OctData::OCT& oct, const BenchConfig& cfg)
+	{
+		std::ofstream stream(file.generic_string(), std::ios::binary);
+		writeBig(stream, static_cast<uint16_t>(cfg.width    ));
+		writeBig(stream, static_cast<uint16_t>(cfg.height   ));
+		writeBig(stream, static_cast<uint16_t>(cfg.numBScans));
+		writeBig(stream, static_cast<uint16_t>(1));
+		writeBig(stream, static_cast<uint16_t>(8));                // image_type: uint8
+		for(int i = 0; i < 4; ++i)
+			writeBig(stream, 1.f);                                 // scales
+		writePadded(stream, "BENCH0001", 80);
+		for(int i = 0; i < 20; ++i)
+			writeBig(stream, 0.f);                                 // matrix
+		writeRaw(stream, static_cast<uint8_t>(0));                 // orientation
+		writeRaw(stream, static_cast<uint8_t>(0));                 // par2
+		writeBig(stream, 0.  );                                    // voxmin
+		writeBig(stream, 255.);                                    // voxmax
+		for(int i = 0; i < 4; ++i)
+			writeBig(stream, 0.);                                  // origin
+		writeBig(stream, 0.f);                                     // pixval_offset
+		writeBig(stream, 1.f);                                     // pixval_cal
+		writeBig(stream, 0.f);                                     // interslicegap
+		writeBig(stream, 0.f);                                     // user_def2
+		writeBig(stream, static_cast<uint32_t>(4026526128u));      // magic_number
+
+		const OctData::Series& series = *oct.begin()->second->begin()->second->begin()->second;
+		for(const OctData::BScan* bscan : series.getBScans())
+		{
+			const cv::Mat& image = bscan->getImage();
+			stream.write(reinterpret_cast<const char*>(image.data), static_cast<std::streamsize>(image.total()));
+		}
+		return stream.good();
+	}
+
+#ifdef TIFFSTACK_SUPPORT
+	// one grayscale page per B-scan
+	bool writeTiffStack(const bfs::path& file, const OctData::OCT& oct)
+	{
+		TIFF* tif = TIFFOpen(file.generic_string().c_str(), "w");
+		if(!tif)
+			return false;
+
+		const OctData::Series& series = *oct.begin()->second->begin()->second->begin()->second;
+		for(const OctData::BScan* bscan : series.getBScans())
+		{
+			const cv::Mat& image = bscan->getImage();
+			TIFFSetField(tif, TIFFTAG_IMAGEWIDTH     , static_cast<uint32_t>(image.cols));
+			TIFFSetField(tif, TIFFTAG_IMAGELENGTH    , static_cast<uint32_t>(image.rows));
+			TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE  , 8);
+			TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 1);
+			TIFFSetField(tif, TIFFTAG_PHOTOMETRIC    , PHOTOMETRIC_MINISBLACK);
+			TIFFSetField(tif, TIFFTAG_PLANARCONFIG   , PLANARCONFIG_CONTIG);
+			TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP   , static_cast<uint32_t>(image.rows));
+			for(int r = 0; r < image.rows; ++r)
+				TIFFWriteScanline(tif, const_cast<uint8_t*>(image.ptr<uint8_t>(r)), static_cast<uint32_t>(r), 0);
+			TIFFWriteDirectory(tif);
+		}
+		TIFFClose(tif);
+		return true;
+	}
+#endif
+
+	// the cirrus export builds the filename from the metadata
+	bfs::path findFile(const bfs::path& dir, const std::string& extension)
+	{
+		for(bfs::directory_iterator it(dir); it != bfs::directory_iterator(); ++it)
+			if(it->path().extension() == extension)
+				return it->path();
+		return bfs::path();
+	}
+
+
+	// --- benchmark ---
+
+	struct FormatFixture
+	{
+		std::string name;
+		std::string filename;
+		// writes the fixture, returns the file to open (empty on error)
+		std::function<bfs::path(const bfs::path& file, const OctData::OCT& oct)> create;
+		bool timedWrite;
+	};
+
+	void runFormat(const BenchConfig& cfg, const FormatFixture& fixture, const OctData::OCT& oct, FormatResult& result)
+	{
+		result.name     = fixture.name;
+		result.hasWrite = fixture.timedWrite;
+
+		const bfs::path formatDir = cfg.fixtureDir / fixture.name;
+		bfs::create_directories(formatDir);
+		const bfs::path file = formatDir / fixture.filename;
+
+		if(fixture.timedWrite)
+		{
+			for(std::size_t i = 0; i < cfg.repeat; ++i)
+			{
+				bfs::path written;
+				result.write.seconds.push_back(measureSeconds([&]() { written = fixture.create(file, oct); }));
+				result.file = written;
+			}
+		}
+		else
+			result.file = fixture.create(file, oct);
+
+		if(result.file.empty() || !bfs::exists(result.file))
+		{
+			result.error = "can't create fixture";
+			return;
+		}
+		result.fileBytes = static_cast<std::size_t>(bfs::file_size(result.file));
+
+		const OctData::FileReadOptions op;
+		for(std::size_t i = 0; i < cfg.repeat; ++i)
+		{
+			std::size_t bscans = 0;
+			std::unique_ptr<OctData::OCT> readOct;
+			result.open.seconds.push_back(measureSeconds([&]()
+			{
+				readOct.reset(new OctData::OCT(OctData::OctFileRead::openFile(result.file.generic_string(), op)));
+				bscans = countBScans(*readOct);
+			}));
+			result.destroy.seconds.push_back(measureSeconds([&]() { readOct.reset(); }));
+			result.bscansRead = bscans;
+		}
+
+		result.ok        = result.bscansRead == cfg.numBScans;
+		result.peakRssKB = peakRssKB();
+		if(!result.ok)
+			result.error = "read " + std::to_string(result.bscansRead) + " of " + std::to_string(cfg.numBScans) + " B-scans";
+	}
+
+	void runCycles(const BenchConfig& cfg, const FormatResult& format, CycleResult& result)
+	{
+		result.format = format.name;
+
+		const OctData::FileReadOptions op;
+		for(std::size_t i = 0; i < cfg.cycles; ++i)
+		{
+			std::unique_ptr<OctData::OCT> readOct;
+			result.open.seconds.push_back(measureSeconds([&]() { readOct.reset(new OctData::OCT(OctData::OctFileRead::openFile(format.file.generic_string(), op))); }));
+			result.destroy.seconds.push_back(measureSeconds([&]() { readOct.reset(); }));
+
+			if(i == 0)
+				result.rssFirstKB = currentRssKB();
+		}
+		result.rssLastKB = currentRssKB();
+		result.peakRssKB = peakRssKB();
+	}
+
+	std::vector<FormatFixture> createFixtures(const BenchConfig& cfg)
+	{
+		std::vector<FormatFixture> fixtures;
+		auto exportFile = [](const bfs::path& file, const OctData::OCT& oct) -> bfs::path
+		{
+			return OctData::OctFileRead::writeFile(file, oct, OctData::FileWriteOptions()) ? file : bfs::path();
+		};
+
+#ifdef HE_VOL_SUPPORT
+		fixtures.push_back({"vol", "bench.vol", [cfg](const bfs::path& file, const OctData::OCT& oct)
+		{
+			return writeVol(file, oct, cfg) ? file : bfs::path();
+		}, false});
+#endif
+#ifdef GIPL_SUPPORT
+		fixtures.push_back({"gipl", "bench.gipl", [cfg](const bfs::path& file, const OctData::OCT& oct)
+		{
+			return writeGipl(file, oct, cfg) ? file : bfs::path();
+		}, false});
+#endif
+#ifdef CIRRUS_RAW_SUPPORT
+		fixtures.push_back({"cirrus_raw", "bench.img", [exportFile](const bfs::path& file, const OctData::OCT& oct)
+		{
+			return exportFile(file, oct).empty() ? bfs::path() : findFile(file.parent_path(), ".img");
+		}, true});
+#endif
+#ifdef CVBIN_SUPPORT
+		fixtures.push_back({"cvbin", "bench.octbin", exportFile, true});
+#endif
+#ifdef XOCT_SUPPORT
+		fixtures.push_back({"xoct", "bench.xoct", exportFile, true});
+#endif
+#ifdef TIFFSTACK_SUPPORT
+		fixtures.push_back({"tiffstack", "bench.tiff", [](const bfs::path& file, const OctData::OCT& oct)
+		{
+			return writeTiffStack(file, oct) ? file : bfs::path();
+		}, false});
+#endif
+		return fixtures;
+	}
+
+
+	// --- json output ---
+
+	std::string jsonString(const std::string& str)
+	{
+		std::ostringstream out;
+		out << '"';
+		for(char c : str)
+		{
+			switch(c)
+			{
+				case '"' : out << "\\\""; break;
+				case '\\': out << "\\\\"; break;
+				case '\n': out << "\\n" ; break;
+				default:
+					if(static_cast<unsigned char>(c) < 0x20)
+						out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+					else
+						out << c;
+			}
+		}
+		out << '"';
+		return out.str();
+	}
+
+	void writeTiming(std::ostream& out, const TimingStats& stats, const FormatResult& result, const BenchConfig& cfg)
+	{
+		const double p50 = stats.percentile(0.5 );
+		const double p99 = stats.percentile(0.99);
+		const double mb  = static_cast<double>(result.fileBytes)/(1024.*1024.);
+		out << "{ \"runs\": "          << stats.seconds.size()
+		    << ", \"p50_ms\": "        << p50*1000.
+		    << ", \"p99_ms\": "        << p99*1000.
+		    << ", \"mb_per_s\": "      << (p50 > 0 ? mb/p50 : 0.)
+		    << ", \"bscans_per_s\": "  << (p50 > 0 ? static_cast<double>(cfg.numBScans)/p50 : 0.)
+		    << " }";
+	}
+
+	void writePercentiles(std::ostream& out, const TimingStats& stats)
+	{
+		out << "{ \"p50_ms\": " << stats.percentile(0.5)*1000. << ", \"p99_ms\": " << stats.percentile(0.99)*1000. << " }";
+	}
+
+	void writeJson(std::ostream& out, const BenchConfig& cfg, const std::vector<FormatResult>& results, const TimingStats& seriesBuild
+	             , const SeriesBuildResult& hullBuild, const AllocResult& alloc, const CycleResult& cycles, const KernelResult& volGray)
+	{
+		out << "{\n";
+		out << "  \"config\": { \"width\": " << cfg.width << ", \"height\": " << cfg.height
+		    << ", \"bscans\": " << cfg.numBScans << ", \"slo_size\": " << cfg.sloSize << ", \"repeat\": " << cfg.repeat
+		    << ", \"cycles\": " << cfg.cycles << ", \"alloc_bscans\": " << cfg.allocBScans << ", \"hull_bscans\": " << cfg.hullBScans << " },\n";
+		out << "  \"series_build\": ";
+		writePercentiles(out, seriesBuild);
+		out << ",\n";
+		out << "  \"series_build_hull\": { \"bscans\": " << cfg.hullBScans << ", \"incremental\": ";
+		writePercentiles(out, hullBuild.incremental);
+		out << ", \"rebuild\": ";
+		writePercentiles(out, hullBuild.rebuild);
+		out << ", \"incremental_area\": " << hullBuild.incrementalArea << ", \"rebuild_area\": " << hullBuild.rebuildArea << " },\n";
+		out << "  \"vol_gray_transform\": { \"instruction_set\": " << jsonString(volGray.instructionSet) << ", \"fused\": ";
+		writePercentiles(out, volGray.fused);
+		out << ", \"three_pass\": ";
+		writePercentiles(out, volGray.threePass);
+		out << ", \"mismatches\": " << volGray.mismatches << " },\n";
+		out << "  \"bscan_alloc\": { \"pool\": ";
+		writePercentiles(out, alloc.pool);
+		out << ", \"heap\": ";
+		writePercentiles(out, alloc.heap);
+		out << " },\n";
+		out << "  \"open_close_cycles\": { \"format\": " << jsonString(cycles.format) << ", \"open\": ";
+		writePercentiles(out, cycles.open);
+		out << ", \"destroy\": ";
+		writePercentiles(out, cycles.destroy);
+		out << ", \"rss_first_kb\": " << cycles.rssFirstKB << ", \"rss_last_kb\": " << cycles.rssLastKB
+		    << ", \"rss_growth_kb\": " << (cycles.rssLastKB - cycles.rssFirstKB) << ", \"peak_rss_kb\": " << cycles.peakRssKB << " },\n";
+		out << "  \"results\": [\n";
+		for(std::size_t i = 0; i < results.size(); ++i)
+		{
+			const FormatResult& r = results[i];
+			out << "    {\n";
+			out << "      \"format\": "      << jsonString(r.name)                  << ",\n";
+			out << "      \"file\": "        << jsonString(r.file.generic_string()) << ",\n";
+			out << "      \"file_bytes\": "  << r.fileBytes                         << ",\n";
+			out << "      \"bscans_read\": " << r.bscansRead                        << ",\n";
+			out << "      \"ok\": "          << (r.ok ? "true" : "false")           << ",\n";
+			out << "      \"error\": "       << jsonString(r.error)                 << ",\n";
+			out << "      \"open\": ";
+			writeTiming(out, r.open, r, cfg);
+			out << ",\n      \"destroy\": ";
+			writePercentiles(out, r.destroy);
+			out << ",\n      \"write\": ";
+			if(r.hasWrite)
+				writeTiming(out, r.write, r, cfg);
+			else
+				out << "null";
+			out << ",\n      \"peak_rss_kb\": " << r.peakRssKB << "\n";
+			out << "    }" << (i + 1 < results.size() ? "," : "") << '\n';
+		}
+		out << "  ]\n}\n";
+	}
+
+	bool parseArguments(int argc, char** argv, BenchConfig& cfg)
+	{
+		for(int i = 1; i + 1 < argc; i += 2)
+		{
+			const std::string arg   = argv[i];
+			const std::string value = argv[i + 1];
+			     if(arg == "--dir"   ) cfg.fixtureDir = value;
+			else if(arg == "--out"   ) cfg.outFile    = value;
+			else if(arg == "--width" ) cfg.width      = std::stoul(value);
+			else if(arg == "--height") cfg.height     = std::stoul(value);
+			else if(arg == "--bscans") cfg.numBScans  = std::stoul(value);
+			else if(arg == "--slo"   ) cfg.sloSize    = std::stoul(value);
+			else if(arg == "--repeat") cfg.repeat     = std::max<std::size_t>(1, std::stoul(value));
+			else if(arg == "--cycles") cfg.cycles     = std::max<std::size_t>(1, std::stoul(value));
+			else
+			{
+				std::cerr << "unknown argument " << arg << std::endl;
+				return false;
+			}
+		}
+		return (argc % 2) == 1;
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	BenchConfig cfg;
+	if(!parseArguments(argc, argv, cfg))
+	{
+		std::cerr << "usage: " << argv[0] << " [--dir fixtures] [--out bench.json] [--width 512] [--height 496] [--bscans 49] [--slo 768] [--repeat 5] [--cycles 20]" << std::endl;
+		return 2;
+	}
+
+	TimingStats seriesBuild;
+	for(std::size_t i = 0; i < cfg.repeat; ++i)
+		seriesBuild.seconds.push_back(timeSeriesBuild(cfg.numBScans));
+	std::cout << "series build: " << seriesBuild.percentile(0.5)*1000. << " ms (p50)" << std::endl;
+
+	SeriesBuildResult hullBuild;
+	for(std::size_t i = 0; i < cfg.repeat; ++i)
+	{
+		hullBuild.incremental.seconds.push_back(timeSeriesBuild(cfg.hullBScans, &hullBuild.incrementalArea));
+		hullBuild.rebuild    .seconds.push_back(timeHullRebuild(cfg.hullBScans, &hullBuild.rebuildArea    ));
+	}
+	std::cout << "series build " << cfg.hullBScans << " B-scans: " << hullBuild.incremental.percentile(0.5)*1000. << " ms incremental hull, "
+	          << hullBuild.rebuild.percentile(0.5)*1000. << " ms rebuilt hull (p50)" << std::endl;
+
+	KernelResult volGray;
+	runVolGrayKernel(cfg, volGray);
+	std::cout << "vol gray transform (" << volGray.instructionSet << "): " << volGray.fused.percentile(0.5)*1e6 << " us fused, "
+	          << volGray.threePass.percentile(0.5)*1e6 << " us three pass (p50, 1024x496), " << volGray.mismatches << " different pixels" << std::endl;
+
+	AllocResult alloc;
+	for(std::size_t i = 0; i < cfg.repeat; ++i)
+	{
+		alloc.pool.seconds.push_back(timeBScanAlloc(cfg, true ));
+		alloc.heap.seconds.push_back(timeBScanAlloc(cfg, false));
+	}
+	std::cout << "B-scan alloc: " << alloc.pool.percentile(0.5)*1000. << " ms pool, " << alloc.heap.percentile(0.5)*1000. << " ms heap (p50, "
+	          << cfg.allocBScans << " B-scans)" << std::endl;
+
+	OctData::OCT oct;
+	createSyntheticOCT(cfg, oct);
+
+	std::vector<FormatResult> results;
+	for(const FormatFixture& fixture : createFixtures(cfg))
+	{
+		results.emplace_back();
+		runFormat(cfg, fixture, oct, results.back());
+
+		const FormatResult& r = results.back();
+		std::cout << std::setw(12) << r.name << ": " << (r.ok ? "ok   " : "FAIL ")
+		          << std::setw(10) << r.open.percentile(0.5)*1000. << " ms (p50)  " << r.error << std::endl;
+	}
+
+	CycleResult cycles;
+	const std::vector<FormatResult>::const_iterator cycleFormat = std::find_if(results.begin(), results.end(), [](const FormatResult& r) { return r.ok; });
+	if(cycleFormat != results.end())
+	{
+		runCycles(cfg, *cycleFormat, cycles);
+		std::cout << "open/close " << cfg.cycles << "x " << cycles.format << ": rss " << cycles.rssFirstKB << " kB after the first close, "
+		          << cycles.rssLastKB << " kB after the last close" << std::endl;
+	}
+
+	std::ofstream out(cfg.outFile.generic_string());
+	writeJson(out, cfg, results, seriesBuild, hullBuild, alloc, cycles, volGray);
+
+	const bool allOk = std::all_of(results.begin(), results.end(), [](const FormatResult& r) { return r.ok; });
+	return allOk ? 0 : 1;
+}
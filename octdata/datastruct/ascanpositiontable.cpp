@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "ascanpositiontable.h"
+
+#include "bscan.h"
+#include "sloimage.h"
+
+#include <algorithm>
+
+namespace OctData
+{
+	AscanPositionTable::AscanPositionTable(const std::vector<BScan*>& bscans)
+	{
+		offsets.reserve(bscans.size() + 1);
+		offsets.push_back(0);
+		for(const BScan* bscan : bscans)
+			offsets.push_back(offsets.back() + (bscan ? static_cast<std::size_t>(std::max(bscan->getWidth(), 0)) : 0));
+
+		xs.resize(offsets.back());
+		ys.resize(offsets.back());
+		for(std::size_t i = 0; i < bscans.size(); ++i)
+			if(bscans[i] && getNumAscans(i) > 0)
+				bscans[i]->getAscanPositions(xs.data() + offsets[i], ys.data() + offsets[i]);
+	}
+
+	void AscanPositionTable::toSloPx(const SloImage& slo, std::vector<double>& x, std::vector<double>& y) const
+	{
+		x.resize(xs.size());
+		y.resize(ys.size());
+		slo.mmToPx(xs.data(), ys.data(), x.data(), y.data(), xs.size());
+	}
+}
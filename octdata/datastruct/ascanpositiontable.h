@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#ifdef OCTDATA_EXPORT
+	#include "octdata_EXPORTS.h"
+#else
+	#define Octdata_EXPORTS
+#endif
+
+
+namespace OctData
+{
+	class BScan;
+	class SloImage;
+
+	// SLO mm positions of all A-scans of a series, x and y in separate contiguous arrays, B-scan after B-scan
+	class AscanPositionTable
+	{
+	public:
+		Octdata_EXPORTS explicit AscanPositionTable(const std::vector<BScan*>& bscans);
+
+		std::size_t getNumBScans()                               const { return offsets.size() - 1; }
+		std::size_t getNumAscans()                               const { return xs.size(); }
+		std::size_t getNumAscans(std::size_t bscan)              const { return offsets[bscan + 1] - offsets[bscan]; }
+
+		const double* getX(std::size_t bscan)                    const { return xs.data() + offsets[bscan]; }
+		const double* getY(std::size_t bscan)                    const { return ys.data() + offsets[bscan]; }
+
+		// positions of all A-scans in SLO pixel (see SloImage::mmToPx)
+		Octdata_EXPORTS void toSloPx(const SloImage& slo, std::vector<double>& x, std::vector<double>& y) const;
+
+	private:
+		std::vector<std::size_t> offsets;                          // first A-scan of each B-scan, last entry: number of A-scans
+		std::vector<double>      xs;
+		std::vector<double>      ys;
+	};
+
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "blockpool.h"
+
+#include <algorithm>
+#include <new>
+
+namespace OctData
+{
+	BlockPool::BlockPool(std::size_t blockSize, std::size_t blocksPerChunk)
+	: blockSize     ((std::max(blockSize, sizeof(FreeBlock)) + alignof(std::max_align_t) - 1)/alignof(std::max_align_t)*alignof(std::max_align_t))
+	, blocksPerChunk(std::max(blocksPerChunk, static_cast<std::size_t>(1)))
+	{
+	}
+
+	BlockPool::~BlockPool()
+	{
+		for(char* chunk : chunks)
+			::operator delete(chunk);
+	}
+
+	void BlockPool::addChunk()
+	{
+		char* chunk = static_cast<char*>(::operator new(blockSize*blocksPerChunk));
+		chunks.push_back(chunk);
+
+		for(std::size_t i = blocksPerChunk; i > 0; --i)
+		{
+			FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + (i - 1)*blockSize);
+			block->next = freeList;
+			freeList    = block;
+		}
+	}
+
+	void* BlockPool::allocate()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(!freeList)
+			addChunk();
+
+		FreeBlock* block = freeList;
+		freeList = block->next;
+		return block;
+	}
+
+	void BlockPool::deallocate(void* block)
+	{
+		if(!block)
+			return;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+		freeBlock->next = freeList;
+		freeList        = freeBlock;
+	}
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace OctData
+{
+	// fixed size blocks from large chunks with a free list, for the many small objects of an import,
+	// freed blocks are reused by the next import, the chunks are kept until the pool is destroyed
+	class BlockPool
+	{
+		struct FreeBlock { FreeBlock* next; };
+
+		const std::size_t  blockSize;
+		const std::size_t  blocksPerChunk;
+		FreeBlock*         freeList = nullptr;
+		std::vector<char*> chunks;
+		std::mutex         mutex;
+
+		void addChunk();
+	public:
+		BlockPool(std::size_t blockSize, std::size_t blocksPerChunk);
+		~BlockPool();
+
+		BlockPool(const BlockPool&)            = delete;
+		BlockPool& operator=(const BlockPool&) = delete;
+
+		std::size_t getBlockSize()                               const { return blockSize; }
+
+		void* allocate();
+		void  deallocate(void* block);
+	};
+}
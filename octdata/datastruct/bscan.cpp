@@ -20,42 +20,185 @@
 #define _USE_MATH_DEFINES
 #include<cmath>
 #include<exception>
+#include<algorithm>
 
 #include <opencv/cv.hpp>
 
+#include "bscanimagecache.h"
+#include "blockpool.h"
+#include "float16.h"
+
 
 namespace OctData
 {
 
+	struct BScan::LazyImage
+	{
+		ImageLoader                           loader;
+		int                                   width;
+		int                                   height;
+		std::shared_ptr<BScanImageCache>      cache;
+		std::shared_ptr<DerivedImageSettings> derivedImageSettings;
+	};
+
+
+	namespace
+	{
+		// never destroyed, B-scans of static objects can outlive a static pool
+		BlockPool& getBScanPool()
+		{
+			static BlockPool* pool = new BlockPool(sizeof(BScan), 256);
+			return *pool;
+		}
+	}
+
+	void* BScan::operator new(std::size_t size)
+	{
+		BlockPool& pool = getBScanPool();
+		if(size > pool.getBlockSize())
+			return ::operator new(size);
+		return pool.allocate();
+	}
+
+	void BScan::operator delete(void* p, std::size_t size)
+	{
+		BlockPool& pool = getBScanPool();
+		if(size > pool.getBlockSize())
+			::operator delete(p);
+		else
+			pool.deallocate(p);
+	}
+
+
 	BScan::BScan(const cv::Mat& img, const BScan::Data& data)
-	: image     (new cv::Mat(img))
-	, angioImage(new cv::Mat)
-	, rawImage  (new cv::Mat)
+	: image     (new cv::Mat[3])
+	, angioImage(image + 1)
+	, rawImage  (image + 2)
 	, data      (data)
 	{
+		*image = img;
+	}
 
+	BScan::BScan(ImageLoader loader, int width, int height, const BScan::Data& data, std::shared_ptr<BScanImageCache> cache
+	           , std::shared_ptr<DerivedImageSettings> derivedImageSettings)
+	: image     (new cv::Mat[3])
+	, angioImage(image + 1)
+	, rawImage  (image + 2)
+	, data      (data)
+	, lazyImage (new LazyImage{std::move(loader), width, height, std::move(cache), std::move(derivedImageSettings)})
+	{
 	}
 
 	BScan::~BScan()
 	{
-		delete image;
-		delete angioImage;
-		delete rawImage;
+		if(lazyImage)
+			lazyImage->cache->remove(*this);
+
+		delete lazyImage;
+		delete[] image;
 	}
 
 	int BScan::getWidth() const
 	{
+		if(lazyImage)
+			return lazyImage->width;
 		return image->cols;
 	}
 
 	int BScan::getHeight() const
 	{
+		if(lazyImage)
+			return lazyImage->height;
 		return image->rows;
 	}
 
-	void BScan::setRawImage(const cv::Mat& img)
+	MemoryUsage BScan::memoryUsage() const
+	{
+		MemoryUsage usage;
+		usage.image      = lazyImage ? lazyImage->cache->imageBytes(*this) : image->total()*image->elemSize();
+		usage.angioImage = angioImage->total()*angioImage->elemSize();
+		usage.rawImage   = rawImage  ->total()*rawImage  ->elemSize();
+		for(Segmentationlines::SegmentlineType type : Segmentationlines::getSegmentlineTypes())
+			usage.segmentation += data.getSegmentLine(type).capacity()*sizeof(Segmentationlines::SegmentlineDataType);
+		return usage;
+	}
+
+	std::shared_ptr<const DerivedImageSettings> BScan::getDerivedImageSettings() const
+	{
+		if(lazyImage)
+			return lazyImage->derivedImageSettings;
+		return nullptr;
+	}
+
+	DerivedImageSettings* BScan::getChangeableDerivedImageSettings() const
+	{
+		if(lazyImage)
+			return lazyImage->derivedImageSettings.get();
+		return nullptr;
+	}
+
+	bool BScan::isImageLoaded() const
+	{
+		if(lazyImage)
+			return lazyImage->cache->isLoaded(*this);
+		return true;
+	}
+
+	cv::Mat BScan::getImage() const
 	{
-		*rawImage = img;
+		if(lazyImage)
+			return lazyImage->cache->copyImage(*this);
+		return *image;
+	}
+
+	cv::Mat BScan::copyImage() const
+	{
+		return getImage();
+	}
+
+	bool BScan::decodeLazyImage() const
+	{
+		cv::Mat img;
+		if(!lazyImage->loader(img) || img.empty())
+			return false;
+		*image = img;
+		return true;
+	}
+
+	void BScan::releaseLazyImage() const
+	{
+		*image = cv::Mat();
+	}
+
+	SegmentlineView BScan::getSegmentLineView(Segmentationlines::SegmentlineType i) const
+	{
+		if(segmentationStore)
+			return segmentationStore->getSegmentLine(i, segmentationIndex);
+		return SegmentlineView(data.getSegmentLine(i));
+	}
+
+	void BScan::setRawImage(const cv::Mat& img, RawImageEncoding encoding)
+	{
+		*rawImage        = img;
+		rawImageEncoding = encoding;
+	}
+
+	cv::Mat BScan::getRawImageFloat() const
+	{
+		if(rawImageEncoding == RawImageEncoding::Float16)
+		{
+			cv::Mat result(rawImage->rows, rawImage->cols, cv::DataType<float>::type);
+			for(int row = 0; row < rawImage->rows; ++row)
+				convertHalfToFloat(rawImage->ptr<uint16_t>(row), result.ptr<float>(row), static_cast<std::size_t>(rawImage->cols));
+			return result;
+		}
+
+		if(rawImage->empty() || rawImage->type() == cv::DataType<float>::type)
+			return *rawImage;
+
+		cv::Mat result;
+		rawImage->convertTo(result, cv::DataType<float>::type);
+		return result;
 	}
 
 	void BScan::setAngioImage(const cv::Mat& img)
@@ -110,6 +253,63 @@ namespace OctData
 		return getFracPos(frac);
 	}
 
+	void BScan::getAscanPositions(double* x, double* y) const
+	{
+		const int width = getWidth();
+		if(width <= 0)
+			return;
+
+		const std::size_t size = static_cast<std::size_t>(width);
+		const double      step = width > 1 ? 1./static_cast<double>(width - 1) : 0.;
+
+		switch(getBScanType())
+		{
+			case BScanType::Line:
+			{
+				const double startX = getStart().getX();
+				const double startY = getStart().getY();
+				const double dx     = (getEnd().getX() - startX)*step;
+				const double dy     = (getEnd().getY() - startY)*step;
+				for(std::size_t i = 0; i < size; ++i)
+				{
+					x[i] = startX + static_cast<double>(i)*dx;
+					y[i] = startY + static_cast<double>(i)*dy;
+				}
+				break;
+			}
+			case BScanType::Circle:
+			{
+				// angle linear in the A-scan number (see calcCirclePos), rotated by a fixed step
+				const CoordSLOmm& center    = getCenter();
+				const double      radius    = center.abs(getStart());
+				const double      nullAngle = acos((getStart().getX() - center.getX())/radius)/M_PI/2;
+				const bool        clockwise = getClockwiseRot();
+
+				const double startAngle = (clockwise ? nullAngle : nullAngle + 1)*2*M_PI;
+				const double stepAngle  = (clockwise ? step : -step)*2*M_PI;
+				const double stepCos    = cos(stepAngle);
+				const double stepSin    = sin(stepAngle);
+
+				double actCos = cos(startAngle);
+				double actSin = sin(startAngle);
+				for(std::size_t i = 0; i < size; ++i)
+				{
+					x[i] = actCos*radius + center.getX();
+					y[i] = actSin*radius + center.getY();
+
+					const double nextCos = actCos*stepCos - actSin*stepSin;
+					actSin               = actSin*stepCos + actCos*stepSin;
+					actCos               = nextCos;
+				}
+				break;
+			}
+			case BScanType::Unknown:
+				std::fill(x, x + size, 0.);
+				std::fill(y, y + size, 0.);
+				break;
+		}
+	}
+
 	template<> void BScan::BScanTypeEnumWrapper::toString()
 	{
 		switch(obj)
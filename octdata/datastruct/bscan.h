@@ -19,9 +19,13 @@
 
 #include <vector>
 #include <array>
+#include <functional>
+#include <memory>
 #include "coordslo.h"
 #include "date.h"
 #include "segmentationlines.h"
+#include "segmentationstore.h"
+#include "memoryusage.h"
 
 namespace cv { class Mat; }
 
@@ -35,12 +39,16 @@ namespace cv { class Mat; }
 
 namespace OctData
 {
+	class BScanImageCache;
+	class DerivedImageSettings;
 
 	// GCL IPL INL OPL ELM PR1 PR2 RPE BM
 	class Octdata_EXPORTS BScan
 	{
 	public:
 		enum class BScanType { Unknown, Line, Circle };
+		// Float16: CV_16UC1 with IEEE half bit patterns (FileReadOptions::RawStorage::float16)
+		enum class RawImageEncoding { Native, Float16 };
 
 		typedef ObjectWrapper<BScanType> BScanTypeEnumWrapper;
 
@@ -71,20 +79,42 @@ namespace OctData
 			                                                              { return segmentationslines.getSegmentLine(i); }
 		};
 
+		// decodes the image of a lazy loaded B-scan, returns false on error
+		typedef std::function<bool(cv::Mat& image)> ImageLoader;
+
 		// BScan();
 		BScan(const cv::Mat& img, const BScan::Data& data);
+		// lazy B-scan: the image is decoded by loader on first access and hold by the cache
+		// with derivedImageSettings the loader derives the image from the raw image (FileReadOptions::deriveBScanImages)
+		BScan(ImageLoader loader, int width, int height, const BScan::Data& data, std::shared_ptr<BScanImageCache> cache
+		    , std::shared_ptr<DerivedImageSettings> derivedImageSettings = nullptr);
 		~BScan();
 
 		BScan(const BScan& other)            = delete;
 		BScan& operator=(const BScan& other) = delete;
 
-		const cv::Mat& getImage()           const                   { return *image                      ; }
+		// B-scans are allocated from a block pool, a volume needs no separate heap allocation per B-scan
+		static void* operator new(std::size_t size);
+		static void  operator delete(void* p, std::size_t size);
+
+		// the cv::Mat shares the pixel data, for lazy B-scans it keeps the image valid when the cache releases it (thread safe)
+		cv::Mat getImage()                  const;
+		// same as getImage
+		cv::Mat copyImage()                 const;
 		const cv::Mat& getAngioImage()      const                   { return *angioImage                 ; }
 		const cv::Mat& getRawImage()        const                   { return *rawImage                   ; }
+		RawImageEncoding getRawImageEncoding() const                { return rawImageEncoding            ; }
+		// raw image as CV_32FC1, half images are decoded (F16C), other types converted
+		cv::Mat getRawImageFloat()          const;
 
-		void setRawImage(const cv::Mat& img);
+		void setRawImage(const cv::Mat& img, RawImageEncoding encoding = RawImageEncoding::Native);
 		void setAngioImage(const cv::Mat& img);
 
+		bool isLazy()                       const                   { return lazyImage != nullptr        ; }
+		// shared by the B-scans of a file with derived images, nullptr otherwise; changed by Series::changeDerivedImageSettings
+		std::shared_ptr<const DerivedImageSettings> getDerivedImageSettings() const;
+		bool isImageLoaded()                const;
+
 
 		const std::string getFilename()     const                   { return data.filename               ; }
 
@@ -105,28 +135,48 @@ namespace OctData
 
 		const CoordSLOmm  getAscanPos(std::size_t ascan) const;
 		const CoordSLOmm  getFracPos(double frac) const;
+		// SLO mm positions of all getWidth() A-scans, same result as getAscanPos without the per point trigonometry
+		void getAscanPositions(double* x, double* y) const;
 
 
 		static std::size_t getNumSegmentLine()            { return Segmentationlines::getSegmentlineTypes().size(); }
+		// empty after Series::packSegmentation, getSegmentLineView serves both storages
 		const Segmentationlines::Segmentline& getSegmentLine(Segmentationlines::SegmentlineType i) const
 		                                                            { return data.getSegmentLine(i); }
+		SegmentlineView getSegmentLineView(Segmentationlines::SegmentlineType i) const;
 
 		const Segmentationlines& getSegmentLines() const            { return data.segmentationslines; }
 
 		int   getWidth()                    const;
 		int   getHeight()                   const;
 
+		// decoded images only, segmentation without the lines of a SegmentationStore
+		MemoryUsage memoryUsage()           const;
+
 
 		template<typename T> void getSetParameter(T& getSet)           { getSetParameter(getSet, *this); }
 		template<typename T> void getSetParameter(T& getSet)     const { getSetParameter(getSet, *this); }
 
 
 	private:
+		// the three headers share one allocation
 		cv::Mat*                                image      = nullptr;
 		cv::Mat*                                angioImage = nullptr;
 		cv::Mat*                                rawImage   = nullptr;
+		RawImageEncoding                        rawImageEncoding = RawImageEncoding::Native;
 		Data                                    data;
 
+		struct LazyImage;
+		LazyImage*                              lazyImage  = nullptr;
+
+		const SegmentationStore*                segmentationStore = nullptr;
+		std::size_t                             segmentationIndex = 0;
+
+		friend class BScanImageCache;
+		friend class Series;
+		bool decodeLazyImage() const;
+		DerivedImageSettings* getChangeableDerivedImageSettings() const;
+		void releaseLazyImage() const;
 
 		template<typename T, typename ParameterSet>
 		static void callSubset(T& getSet, ParameterSet& p, const std::string& name)
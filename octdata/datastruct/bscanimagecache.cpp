@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bscanimagecache.h"
+
+#include "bscan.h"
+
+#include <opencv/cv.hpp>
+
+#include <boost/log/trivial.hpp>
+
+
+namespace OctData
+{
+
+	BScanImageCache::BScanImageCache(std::size_t maxBytes)
+	: maxBytes(maxBytes)
+	{
+	}
+
+	BScanImageCache::~BScanImageCache()
+	{
+		clear();
+	}
+
+	std::size_t BScanImageCache::getMaxBytes() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return maxBytes;
+	}
+
+	void BScanImageCache::setMaxBytes(std::size_t bytes)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		maxBytes = bytes;
+		shrink();
+	}
+
+	std::size_t BScanImageCache::getUsedBytes() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return usedBytes;
+	}
+
+	std::size_t BScanImageCache::numLoadedBScans() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return lru.size();
+	}
+
+	void BScanImageCache::clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for(const Entry& entry : lru)
+			entry.bscan->releaseLazyImage();
+		lru.clear();
+		entries.clear();
+		usedBytes = 0;
+	}
+
+
+	// the copy is made under the lock, an other thread can't release the image in between
+	cv::Mat BScanImageCache::copyImage(const BScan& bscan)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return loadImage(bscan);
+	}
+
+	bool BScanImageCache::isLoaded(const BScan& bscan) const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return entries.find(&bscan) != entries.end();
+	}
+
+	std::size_t BScanImageCache::imageBytes(const BScan& bscan) const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = entries.find(&bscan);
+		if(it == entries.end())
+			return 0;
+		return it->second->bytes;
+	}
+
+	const cv::Mat& BScanImageCache::loadImage(const BScan& bscan)
+	{
+		auto it = entries.find(&bscan);
+		if(it != entries.end())
+		{
+			lru.splice(lru.begin(), lru, it->second);
+			return *bscan.image;
+		}
+
+		// the file readers of the loaders are not thread safe, decode under the lock
+		if(!bscan.decodeLazyImage())
+		{
+			BOOST_LOG_TRIVIAL(error) << "Can't load B-scan image " << bscan.getFilename();
+			return *bscan.image;
+		}
+
+		const cv::Mat& image = *bscan.image;
+		const std::size_t bytes = image.total()*image.elemSize();
+
+		lru.push_front(Entry{&bscan, bytes});
+		entries[&bscan] = lru.begin();
+		usedBytes += bytes;
+
+		shrink();
+		return image;
+	}
+
+	void BScanImageCache::remove(const BScan& bscan)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto it = entries.find(&bscan);
+		if(it == entries.end())
+			return;
+
+		usedBytes -= it->second->bytes;
+		lru.erase(it->second);
+		entries.erase(it);
+	}
+
+	void BScanImageCache::shrink()
+	{
+		while(usedBytes > maxBytes && lru.size() > 1)
+		{
+			const Entry& entry = lru.back();
+			entry.bscan->releaseLazyImage();
+			usedBytes -= entry.bytes;
+			entries.erase(entry.bscan);
+			lru.pop_back();
+		}
+	}
+
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace cv { class Mat; }
+
+
+#ifdef OCTDATA_EXPORT
+	#include "octdata_EXPORTS.h"
+#else
+	#define Octdata_EXPORTS
+#endif
+
+
+namespace OctData
+{
+	class BScan;
+
+	// LRU cache for the images of lazy loaded B-scans (see FileReadOptions::lazyBScans)
+	// the cache is shared by all B-scans of a file and limits the memory of the decoded images,
+	// the least recently used images are released when the limit is exceeded (the last used image is always kept),
+	// the images are handed out as copies of the cv::Mat, a released image stays valid for its holders
+	class Octdata_EXPORTS BScanImageCache
+	{
+		BScanImageCache(const BScanImageCache&)            = delete;
+		BScanImageCache& operator=(const BScanImageCache&) = delete;
+
+	public:
+		explicit BScanImageCache(std::size_t maxBytes);
+		~BScanImageCache();
+
+		std::size_t getMaxBytes()                                const;
+		void setMaxBytes(std::size_t bytes);
+
+		std::size_t getUsedBytes()                               const;
+		std::size_t numLoadedBScans()                            const;
+
+		void clear();
+
+	private:
+		friend class BScan;
+
+		struct Entry
+		{
+			const BScan* bscan;
+			std::size_t  bytes;
+		};
+		typedef std::list<Entry> EntryList;
+
+		cv::Mat copyImage(const BScan& bscan);
+		bool isLoaded(const BScan& bscan)                        const;
+		std::size_t imageBytes(const BScan& bscan)               const;
+		const cv::Mat& loadImage(const BScan& bscan);
+		void remove(const BScan& bscan);
+		void shrink();
+
+		mutable std::mutex                                     mutex;
+		EntryList                                              lru;             // front: last used
+		std::unordered_map<const BScan*, EntryList::iterator> entries;
+		std::size_t                                            maxBytes;
+		std::size_t                                            usedBytes = 0;
+	};
+}
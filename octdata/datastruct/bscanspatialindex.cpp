@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "bscanspatialindex.h"
+
+#include "bscan.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <boost/geometry.hpp>
+#include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/geometries/point_xy.hpp>
+#include <boost/geometry/geometries/segment.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
+namespace bg  = boost::geometry;
+namespace bgi = boost::geometry::index;
+
+namespace OctData
+{
+	namespace
+	{
+		typedef bg::model::d2::point_xy<double> Point;
+		typedef bg::model::box<Point>           Box;
+
+		const std::size_t circleSegments = 64;
+
+		// piece of a B-scan path, frac: position on the B-scan (0: first A-scan, 1: last A-scan)
+		struct PathSegment
+		{
+			std::size_t bscan;
+			double      startX, startY;
+			double      endX  , endY;
+			double      startFrac;
+			double      endFrac;
+		};
+
+		typedef std::pair<Box, std::size_t> TreeValue;             // envelope, index in the segment list
+
+		// nearest point of the segment to (x, y)
+		void projectOnSegment(const PathSegment& seg, double x, double y, double& distance, double& frac)
+		{
+			const double dx  = seg.endX - seg.startX;
+			const double dy  = seg.endY - seg.startY;
+			const double len = dx*dx + dy*dy;
+
+			double t = 0;
+			if(len > 0)
+				t = std::max(0., std::min(1., ((x - seg.startX)*dx + (y - seg.startY)*dy)/len));
+
+			const double px = seg.startX + t*dx - x;
+			const double py = seg.startY + t*dy - y;
+			distance = std::sqrt(px*px + py*py);
+			frac     = seg.startFrac + t*(seg.endFrac - seg.startFrac);
+		}
+	}
+
+	struct BScanSpatialIndex::Tree
+	{
+		std::vector<PathSegment>                    segments;
+		bgi::rtree<TreeValue, bgi::quadratic<16>>   rtree;
+	};
+
+
+	BScanSpatialIndex::BScanSpatialIndex(const std::vector<BScan*>& bscans)
+	: tree(new Tree)
+	, bscanWidth(bscans.size(), 0)
+	{
+		std::vector<TreeValue> values;
+		for(std::size_t i = 0; i < bscans.size(); ++i)
+		{
+			const BScan* bscan = bscans[i];
+			if(!bscan || bscan->getBScanType() == BScan::BScanType::Unknown)
+				continue;
+
+			bscanWidth[i] = static_cast<std::size_t>(std::max(bscan->getWidth(), 0));
+
+			const std::size_t numSegments = bscan->getBScanType() == BScan::BScanType::Circle ? circleSegments : 1;
+			CoordSLOmm last = bscan->getFracPos(0);
+			for(std::size_t s = 1; s <= numSegments; ++s)
+			{
+				const double     startFrac = static_cast<double>(s - 1)/static_cast<double>(numSegments);
+				const double     endFrac   = static_cast<double>(s    )/static_cast<double>(numSegments);
+				const CoordSLOmm act       = bscan->getFracPos(endFrac);
+
+				const PathSegment seg{i, last.getX(), last.getY(), act.getX(), act.getY(), startFrac, endFrac};
+				const Box box(Point(std::min(seg.startX, seg.endX), std::min(seg.startY, seg.endY))
+				            , Point(std::max(seg.startX, seg.endX), std::max(seg.startY, seg.endY)));
+
+				values.emplace_back(box, tree->segments.size());
+				tree->segments.push_back(seg);
+				last = act;
+			}
+		}
+
+		// packing construction
+		tree->rtree = bgi::rtree<TreeValue, bgi::quadratic<16>>(values.begin(), values.end());
+	}
+
+	BScanSpatialIndex::~BScanSpatialIndex()
+	{
+		delete tree;
+	}
+
+	bool BScanSpatialIndex::findNearestAscan(const CoordSLOmm& pos, AscanHit& hit) const
+	{
+		if(tree->rtree.empty())
+			return false;
+
+		const Point point(pos.getX(), pos.getY());
+
+		double bestDistance = std::numeric_limits<double>::infinity();
+		double bestFrac     = 0;
+		const PathSegment* bestSegment = nullptr;
+		auto refine = [&](const std::vector<TreeValue>& candidates)
+		{
+			for(const TreeValue& value : candidates)
+			{
+				const PathSegment& seg = tree->segments[value.second];
+				double distance;
+				double frac;
+				projectOnSegment(seg, pos.getX(), pos.getY(), distance, frac);
+				if(distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestFrac     = frac;
+					bestSegment  = &seg;
+				}
+			}
+		};
+
+		// the nearest envelopes give an upper bound, every closer segment has an envelope within this distance
+		std::vector<TreeValue> candidates;
+		tree->rtree.query(bgi::nearest(point, 4), std::back_inserter(candidates));
+		refine(candidates);
+
+		candidates.clear();
+		const Box searchBox(Point(pos.getX() - bestDistance, pos.getY() - bestDistance), Point(pos.getX() + bestDistance, pos.getY() + bestDistance));
+		tree->rtree.query(bgi::intersects(searchBox), std::back_inserter(candidates));
+		refine(candidates);
+
+		if(!bestSegment)
+			return false;
+
+		const std::size_t width = bscanWidth[bestSegment->bscan];
+		hit.bscan    = bestSegment->bscan;
+		hit.ascan    = width > 1 ? static_cast<std::size_t>(std::round(bestFrac*static_cast<double>(width - 1))) : 0;
+		hit.distance = bestDistance;
+		return true;
+	}
+
+	std::vector<std::size_t> BScanSpatialIndex::findBScans(const CoordSLOmm& leftUpper, const CoordSLOmm& rightLower) const
+	{
+		const Box region(Point(std::min(leftUpper.getX(), rightLower.getX()), std::min(leftUpper.getY(), rightLower.getY()))
+		               , Point(std::max(leftUpper.getX(), rightLower.getX()), std::max(leftUpper.getY(), rightLower.getY())));
+
+		std::vector<TreeValue> candidates;
+		tree->rtree.query(bgi::intersects(region), std::back_inserter(candidates));
+
+		std::vector<std::size_t> result;
+		for(const TreeValue& value : candidates)
+		{
+			const PathSegment& seg = tree->segments[value.second];
+			const bg::model::segment<Point> segment(Point(seg.startX, seg.startY), Point(seg.endX, seg.endY));
+			if(bg::intersects(segment, region))
+				result.push_back(seg.bscan);
+		}
+
+		std::sort(result.begin(), result.end());
+		result.erase(std::unique(result.begin(), result.end()), result.end());
+		return result;
+	}
+
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#include "coordslo.h"
+
+#ifdef OCTDATA_EXPORT
+	#include "octdata_EXPORTS.h"
+#else
+	#define Octdata_EXPORTS
+#endif
+
+
+namespace OctData
+{
+	class BScan;
+
+	// R-tree over the B-scan paths of a series in SLO mm coordinates (lines as one segment, circles as polygon)
+	class BScanSpatialIndex
+	{
+	public:
+		struct AscanHit
+		{
+			std::size_t bscan    = 0;
+			std::size_t ascan    = 0;
+			double      distance = 0;                                  // mm between the query position and the A-scan position on the path
+		};
+
+		Octdata_EXPORTS explicit BScanSpatialIndex(const std::vector<BScan*>& bscans);
+		Octdata_EXPORTS ~BScanSpatialIndex();
+
+		BScanSpatialIndex(const BScanSpatialIndex&)            = delete;
+		BScanSpatialIndex& operator=(const BScanSpatialIndex&) = delete;
+
+		// nearest A-scan to pos, false if the series has no B-scan with a position
+		Octdata_EXPORTS bool findNearestAscan(const CoordSLOmm& pos, AscanHit& hit) const;
+
+		// sorted indices of the B-scans whose path intersects the rectangle
+		Octdata_EXPORTS std::vector<std::size_t> findBScans(const CoordSLOmm& leftUpper, const CoordSLOmm& rightLower) const;
+
+	private:
+		struct Tree;
+		Tree* tree = nullptr;
+
+		std::vector<std::size_t> bscanWidth;
+	};
+
+}
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <cmath>
+#include <cstddef>
 #include <ostream>
 
 namespace OctData
@@ -174,6 +175,18 @@ namespace OctData
 		CoordSLOmm operator*(const CoordSLOmm& mm) const            { return CoordSLOmm(a11*mm.getX()  + a12*mm.getY()  + b1, a21*mm.getX()  + a22*mm.getY()  + b2); }
 		CoordSLOpx operator*(const CoordSLOpx& px) const            { return CoordSLOpx(a11*px.getXf() + a12*px.getYf() + b1, a21*px.getXf() + a22*px.getYf() + b2); }
 
+		// the same for size points in separate x and y arrays (in place allowed)
+		void apply(const double* x, const double* y, double* outX, double* outY, std::size_t size) const
+		{
+			for(std::size_t i = 0; i < size; ++i)
+			{
+				const double px = x[i];
+				const double py = y[i];
+				outX[i] = a11*px + a12*py + b1;
+				outY[i] = a21*px + a22*py + b2;
+			}
+		}
+
 		template<typename T> void getSetParameter(T& getSet)           { getSetParameter(getSet, *this); }
 		template<typename T> void getSetParameter(T& getSet)     const { getSetParameter(getSet, *this); }
 
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "enfaceprojection.h"
+
+#include "series.h"
+#include "bscan.h"
+#include "sloraster.h"
+#include "../import/threadpool.h"
+
+#include <opencv/cv.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace OctData
+{
+	namespace
+	{
+		const float invalidValue = std::numeric_limits<float>::quiet_NaN();
+
+		// slab rows [top, bottom) per A-scan
+		struct Slab
+		{
+			std::vector<int> top;
+			std::vector<int> bottom;
+		};
+
+		int clampRow(double row, int rows)
+		{
+			return static_cast<int>(std::max(0., std::min(row, static_cast<double>(rows))));
+		}
+
+		void calcSlab(const BScan& bscan, const EnFaceProjection::Parameter& parameter, int rows, int cols, Slab& slab)
+		{
+			slab.top   .assign(static_cast<std::size_t>(cols), 0);
+			slab.bottom.assign(static_cast<std::size_t>(cols), 0);
+
+			if(parameter.slabType == EnFaceProjection::SlabType::FixedDepth)
+			{
+				std::fill(slab.top   .begin(), slab.top   .end(), clampRow(parameter.depthBegin, rows));
+				std::fill(slab.bottom.begin(), slab.bottom.end(), clampRow(parameter.depthEnd  , rows));
+				return;
+			}
+
+			const SegmentlineView fromLine = bscan.getSegmentLineView(parameter.fromLayer);
+			const SegmentlineView toLine   = bscan.getSegmentLineView(parameter.toLayer  );
+			const std::size_t     segSize  = std::min(fromLine.size(), toLine.size());
+			if(segSize == 0)
+				return;
+
+			// the angio image can have an other width than the segmentation
+			for(std::size_t col = 0; col < static_cast<std::size_t>(cols); ++col)
+			{
+				const std::size_t segIndex = col*segSize/static_cast<std::size_t>(cols);
+				const double      from     = fromLine[segIndex];
+				const double      to       = toLine  [segIndex];
+				if(std::isnan(from) || std::isnan(to))
+					continue;
+
+				slab.top   [col] = clampRow(std::ceil (from + parameter.fromOffset)    , rows);
+				slab.bottom[col] = clampRow(std::floor(to   + parameter.toOffset  ) + 1, rows);
+			}
+		}
+
+		// walks the image row by row (cache friendly), the slab test is a select to keep the inner loop vectorizable
+		template<typename T>
+		void projectImage(const cv::Mat& image, const Slab& slab, EnFaceProjection::Method method, float* out)
+		{
+			const std::size_t cols = static_cast<std::size_t>(image.cols);
+			const int rowBegin = *std::min_element(slab.top   .begin(), slab.top   .end());
+			const int rowEnd   = *std::max_element(slab.bottom.begin(), slab.bottom.end());
+
+			const float init = method == EnFaceProjection::Method::Max ?  -std::numeric_limits<float>::infinity()
+			                 : method == EnFaceProjection::Method::Min ?   std::numeric_limits<float>::infinity()
+			                 : 0.f;
+			std::vector<float> acc  (cols, init);
+			std::vector<float> count(cols, 0.f);
+
+			const int* top    = slab.top   .data();
+			const int* bottom = slab.bottom.data();
+			float* accData   = acc  .data();
+			float* countData = count.data();
+			for(int row = rowBegin; row < rowEnd; ++row)
+			{
+				const T* line = image.ptr<T>(row);
+				switch(method)
+				{
+					case EnFaceProjection::Method::Mean:
+						for(std::size_t col = 0; col < cols; ++col)
+						{
+							const bool inside = row >= top[col] && row < bottom[col];
+							accData  [col] += inside ? static_cast<float>(line[col]) : 0.f;
+							countData[col] += inside ? 1.f : 0.f;
+						}
+						break;
+					case EnFaceProjection::Method::Max:
+						for(std::size_t col = 0; col < cols; ++col)
+						{
+							const bool inside = row >= top[col] && row < bottom[col];
+							accData  [col]  = inside ? std::max(accData[col], static_cast<float>(line[col])) : accData[col];
+							countData[col] += inside ? 1.f : 0.f;
+						}
+						break;
+					case EnFaceProjection::Method::Min:
+						for(std::size_t col = 0; col < cols; ++col)
+						{
+							const bool inside = row >= top[col] && row < bottom[col];
+							accData  [col]  = inside ? std::min(accData[col], static_cast<float>(line[col])) : accData[col];
+							countData[col] += inside ? 1.f : 0.f;
+						}
+						break;
+				}
+			}
+
+			for(std::size_t col = 0; col < cols; ++col)
+			{
+				if(count[col] == 0.f)
+					out[col] = invalidValue;
+				else if(method == EnFaceProjection::Method::Mean)
+					out[col] = acc[col]/count[col];
+				else
+					out[col] = acc[col];
+			}
+		}
+
+		// returns false for unsupported image types
+		bool projectImage(const cv::Mat& image, const Slab& slab, EnFaceProjection::Method method, float* out)
+		{
+			if(image.channels() != 1)
+				return false;
+
+			switch(image.depth())
+			{
+				case CV_8U : projectImage<uint8_t >(image, slab, method, out); return true;
+				case CV_16U: projectImage<uint16_t>(image, slab, method, out); return true;
+				case CV_16S: projectImage<int16_t >(image, slab, method, out); return true;
+				case CV_32S: projectImage<int32_t >(image, slab, method, out); return true;
+				case CV_32F: projectImage<float   >(image, slab, method, out); return true;
+				case CV_64F: projectImage<double  >(image, slab, method, out); return true;
+			}
+			return false;
+		}
+	}
+
+
+	EnFaceProjection::EnFaceProjection(const Series& series, const Parameter& parameter)
+	: parameter      (parameter)
+	, bscanProjection(new cv::Mat)
+	, sloMap         (new cv::Mat)
+	{
+		const Series::BScanList bscans = series.getBScans();
+		const bool angio = parameter.source == Source::Angio;
+
+		int numAscans = 0;
+		for(const BScan* bscan : bscans)
+			if(bscan)
+				numAscans = std::max(numAscans, angio ? bscan->getAngioImage().cols : bscan->getWidth());
+
+		*bscanProjection = cv::Mat(static_cast<int>(bscans.size()), numAscans, cv::DataType<float>::type, cv::Scalar(invalidValue));
+		std::vector<int> rowLength(bscans.size(), 0);
+
+		auto projectRows = [this, &bscans, &rowLength, angio](std::size_t begin, std::size_t end)
+		{
+			Slab slab;
+			for(std::size_t row = begin; row < end; ++row)
+			{
+				const BScan* bscan = bscans[row];
+				if(!bscan)
+					continue;
+
+				// copy holds the image of lazy B-scans while it is in use
+				const cv::Mat image = angio ? bscan->getAngioImage() : bscan->copyImage();
+				if(image.empty())
+					continue;
+
+				calcSlab(*bscan, this->parameter, image.rows, image.cols, slab);
+				if(projectImage(image, slab, this->parameter.method, bscanProjection->ptr<float>(static_cast<int>(row))))
+					rowLength[row] = image.cols;
+			}
+		};
+
+		ThreadPool::parallelFor(bscans.size(), 4, projectRows);
+
+		rasterizeToSlo(series, *bscanProjection, rowLength, *sloMap);
+	}
+
+	EnFaceProjection::~EnFaceProjection()
+	{
+		delete bscanProjection;
+		delete sloMap;
+	}
+
+}
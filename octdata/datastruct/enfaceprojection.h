@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include "segmentationlines.h"
+
+namespace cv { class Mat; }
+
+#ifdef OCTDATA_EXPORT
+	#include "octdata_EXPORTS.h"
+#else
+	#define Octdata_EXPORTS
+#endif
+
+
+namespace OctData
+{
+	class Series;
+
+	// en-face projection of the B-scan images (or angio images) of a series over a slab between two segmentation lines or a fixed depth
+	class EnFaceProjection
+	{
+	public:
+		enum class Method   { Mean, Max, Min };
+		enum class Source   { Image, Angio };
+		enum class SlabType { Layers, FixedDepth };
+
+		struct Parameter
+		{
+			Method   method   = Method::Mean;
+			Source   source   = Source::Image;
+			SlabType slabType = SlabType::Layers;
+
+			Segmentationlines::SegmentlineType fromLayer = Segmentationlines::SegmentlineType::ILM;
+			Segmentationlines::SegmentlineType toLayer   = Segmentationlines::SegmentlineType::BM;
+			int fromOffset = 0;                                        // pixel added to the layers (slab rows: [fromLayer + fromOffset, toLayer + toOffset])
+			int toOffset   = 0;
+
+			int depthBegin = 0;                                        // slab rows for FixedDepth: [depthBegin, depthEnd)
+			int depthEnd   = 0;
+		};
+
+		Octdata_EXPORTS EnFaceProjection(const Series& series, const Parameter& parameter);
+		Octdata_EXPORTS ~EnFaceProjection();
+
+		EnFaceProjection(const EnFaceProjection&)            = delete;
+		EnFaceProjection& operator=(const EnFaceProjection&) = delete;
+
+		const Parameter& getParameter()                          const { return parameter; }
+
+		// CV_32F, one row per B-scan, one column per A-scan, NaN for A-scans with empty slab
+		const cv::Mat& getBScanProjection()                      const { return *bscanProjection; }
+		// CV_32F in the pixel grid of the SLO image, empty if the series has no SLO image
+		const cv::Mat& getSloMap()                               const { return *sloMap; }
+
+	private:
+		Parameter parameter;
+
+		cv::Mat* bscanProjection = nullptr;
+		cv::Mat* sloMap          = nullptr;
+	};
+
+}
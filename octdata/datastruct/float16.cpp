@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "float16.h"
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#include <immintrin.h>
+	#define FLOAT16_RUNTIME_DISPATCH
+	#define FLOAT16_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace OctData
+{
+	namespace
+	{
+		typedef void (*FloatToHalfKernel)(const float* in, uint16_t* out, std::size_t size);
+		typedef void (*HalfToFloatKernel)(const uint16_t* in, float* out, std::size_t size);
+
+		inline uint32_t floatBits(float value)                   { uint32_t bits; std::memcpy(&bits, &value, sizeof(bits)); return bits; }
+		inline float    bitsFloat(uint32_t bits)                 { float value; std::memcpy(&value, &bits, sizeof(value)); return value; }
+
+		uint16_t floatToHalf(float value)
+		{
+			const uint32_t bits = floatBits(value);
+			const uint32_t sign = (bits >> 16) & 0x8000u;
+			const uint32_t abs  =  bits & 0x7FFFFFFFu;
+
+			uint32_t half;
+			if(abs >= 0x7F800000u)                                        // inf, NaN with the upper payload bits and the quiet bit
+				half = 0x7C00u | (abs > 0x7F800000u ? 0x200u | ((abs >> 13) & 0x3FFu) : 0u);
+			else if(abs >= 0x477FF000u)                                   // rounds to 2^16 and more
+				half = 0x7C00u;
+			else if(abs < 0x38800000u)                                    // half denormal: the float addition rounds to the 2^-24 grid
+				half = floatBits(bitsFloat(abs) + bitsFloat(126u << 23)) - (126u << 23);
+			else                                                          // normal: rebias the exponent, round to nearest even
+				half = (abs + 0xC8000FFFu + ((abs >> 13) & 1u)) >> 13;
+			return static_cast<uint16_t>(sign | half);
+		}
+
+		float halfToFloat(uint16_t value)
+		{
+			const uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+			const uint32_t exp  = (value >> 10) & 0x1Fu;
+			const uint32_t mant =  value & 0x3FFu;
+
+			if(exp == 0x1Fu)                                              // inf, NaN (quiet)
+				return bitsFloat(sign | 0x7F800000u | (mant ? 0x400000u | (mant << 13) : 0u));
+			if(exp != 0)
+				return bitsFloat(sign | ((exp + 112u) << 23) | (mant << 13));
+			const float denormal = static_cast<float>(mant)*bitsFloat(103u << 23); // mant*2^-24, exact
+			return bitsFloat(sign | floatBits(denormal));
+		}
+
+		void floatToHalfScalar(const float* in, uint16_t* out, std::size_t size)
+		{
+			for(std::size_t i = 0; i < size; ++i)
+				out[i] = floatToHalf(in[i]);
+		}
+
+		void halfToFloatScalar(const uint16_t* in, float* out, std::size_t size)
+		{
+			for(std::size_t i = 0; i < size; ++i)
+				out[i] = halfToFloat(in[i]);
+		}
+
+#ifdef FLOAT16_RUNTIME_DISPATCH
+		FLOAT16_TARGET("avx,f16c")
+		void floatToHalfF16C(const float* in, uint16_t* out, std::size_t size)
+		{
+			std::size_t i = 0;
+			for(; i + 16 <= size; i += 16)
+			{
+				const __m128i h0 = _mm256_cvtps_ph(_mm256_loadu_ps(in + i    ), _MM_FROUND_TO_NEAREST_INT);
+				const __m128i h1 = _mm256_cvtps_ph(_mm256_loadu_ps(in + i + 8), _MM_FROUND_TO_NEAREST_INT);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i    ), h0);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), h1);
+			}
+			floatToHalfScalar(in + i, out + i, size - i);
+		}
+
+		FLOAT16_TARGET("avx,f16c")
+		void halfToFloatF16C(const uint16_t* in, float* out, std::size_t size)
+		{
+			std::size_t i = 0;
+			for(; i + 16 <= size; i += 16)
+			{
+				_mm256_storeu_ps(out + i    , _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i    ))));
+				_mm256_storeu_ps(out + i + 8, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8))));
+			}
+			halfToFloatScalar(in + i, out + i, size - i);
+		}
+#endif
+
+		struct Float16Dispatch
+		{
+			FloatToHalfKernel toHalf         = &floatToHalfScalar;
+			HalfToFloatKernel toFloat        = &halfToFloatScalar;
+			const char*       instructionSet = "scalar";
+
+			Float16Dispatch()
+			{
+#ifdef FLOAT16_RUNTIME_DISPATCH
+				__builtin_cpu_init();
+				if(__builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c"))
+				{
+					toHalf         = &floatToHalfF16C;
+					toFloat        = &halfToFloatF16C;
+					instructionSet = "F16C";
+				}
+#endif
+			}
+		};
+
+		const Float16Dispatch& getDispatch()
+		{
+			static const Float16Dispatch dispatch;
+			return dispatch;
+		}
+	}
+
+	void convertFloatToHalf(const float* in, uint16_t* out, std::size_t size)
+	{
+		getDispatch().toHalf(in, out, size);
+	}
+
+	void convertHalfToFloat(const uint16_t* in, float* out, std::size_t size)
+	{
+		getDispatch().toFloat(in, out, size);
+	}
+
+	const char* float16InstructionSet()
+	{
+		return getDispatch().instructionSet;
+	}
+}
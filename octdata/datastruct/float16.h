@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace OctData
+{
+	// conversion between float and IEEE 754 half precision (binary16) bit patterns,
+	// round to nearest even, overflow to infinity, NaN stays (quiet) NaN; the same bits as the F16C instructions
+	// the instruction set (scalar, F16C) is chosen at runtime, in and out need no alignment
+	void convertFloatToHalf(const float* in, uint16_t* out, std::size_t size);
+	void convertHalfToFloat(const uint16_t* in, float* out, std::size_t size);
+
+	// name of the instruction set used by the conversions
+	const char* float16InstructionSet();
+}
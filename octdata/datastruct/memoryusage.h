@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+
+namespace OctData
+{
+	// bytes referenced by the data structures (pixel data shared between images is counted for each image)
+	struct MemoryUsage
+	{
+		std::size_t image        = 0;
+		std::size_t angioImage   = 0;
+		std::size_t rawImage     = 0;
+		std::size_t segmentation = 0;
+		std::size_t slo          = 0;
+
+		std::size_t total()                                      const { return image + angioImage + rawImage + segmentation + slo; }
+
+		MemoryUsage& operator+=(const MemoryUsage& o)
+		{
+			image        += o.image       ;
+			angioImage   += o.angioImage  ;
+			rawImage     += o.rawImage    ;
+			segmentation += o.segmentation;
+			slo          += o.slo         ;
+			return *this;
+		}
+	};
+}
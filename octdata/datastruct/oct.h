@@ -17,11 +17,19 @@
 
 #pragma once
 
+#include <memory>
+
 #include "substructure_template.h"
 #include "patient.h"
 
 namespace OctData
 {
+	class OCT;
+
+	// read only OCT shared between threads, the const interface is thread safe (images of lazy B-scans by BScan::copyImage),
+	// the pixel data is shared by the cv::Mat reference counts, a consumer holds the whole OCT by a copy of the pointer
+	typedef std::shared_ptr<const OCT> OCTSnapshot;
+
 	class OCT : public SubstructureTemplate<Patient>
 	{
 	public:
@@ -33,6 +41,9 @@ namespace OctData
 
 		Octdata_EXPORTS void findSeries(const OctData::Series* series, const OctData::Patient*& pat, const OctData::Study*& study) const;
 
+		// moves the OCT into a snapshot, oct is empty afterwards
+		Octdata_EXPORTS static OCTSnapshot makeSnapshot(OCT&& oct)            { return std::make_shared<const OCT>(std::move(oct)); }
+
 
 		template<typename T> void getSetParameter(T& /*getSet*/)       { }
 		template<typename T> void getSetParameter(T& /*getSet*/) const { }
@@ -33,8 +33,9 @@ namespace OctData
 	// GCL IPL INL OPL ELM PR1 PR2 RPE BM
 	class Octdata_EXPORTS  Segmentationlines
 	{
-		static const std::size_t numSegmentlineType = 12;
 	public:
+		static const std::size_t numSegmentlineType = 12;
+
 		enum class SegmentlineType
 		{
 			ILM ,
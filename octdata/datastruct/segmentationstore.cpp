@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "segmentationstore.h"
+
+#include "bscan.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace OctData
+{
+	namespace
+	{
+		int16_t toFixedPoint(double value)
+		{
+			if(!std::isfinite(value))
+				return SegmentationStore::invalidInt16;
+
+			const double fixed = std::round(value/SegmentationStore::int16Scale);
+			if(fixed <= static_cast<double>(SegmentationStore::invalidInt16) || fixed > static_cast<double>(std::numeric_limits<int16_t>::max()))
+				return SegmentationStore::invalidInt16;
+			return static_cast<int16_t>(fixed);
+		}
+	}
+
+
+	const     int16_t SegmentationStore::invalidInt16;
+	constexpr double  SegmentationStore::int16Scale;
+
+
+	double SegmentlineView::operator[](std::size_t i) const
+	{
+		if(dataDouble)
+			return dataDouble[i];
+		if(dataFloat)
+			return static_cast<double>(dataFloat[i]);
+		if(dataInt16[i] == SegmentationStore::invalidInt16)
+			return std::numeric_limits<double>::quiet_NaN();
+		return static_cast<double>(dataInt16[i])*scale;
+	}
+
+	Segmentationlines::Segmentline SegmentlineView::toVector() const
+	{
+		if(dataDouble)
+			return Segmentationlines::Segmentline(dataDouble, dataDouble + numValues);
+
+		Segmentationlines::Segmentline line(numValues);
+		for(std::size_t i = 0; i < numValues; ++i)
+			line[i] = (*this)[i];
+		return line;
+	}
+
+
+	SegmentationStore::SegmentationStore(const std::vector<BScan*>& bscans, Precision precision)
+	: precision(precision)
+	, numBScans(bscans.size())
+	{
+		for(const BScan* bscan : bscans)
+			if(bscan)
+				for(Segmentationlines::SegmentlineType type : Segmentationlines::getSegmentlineTypes())
+					numAscans = std::max(numAscans, bscan->getSegmentLineView(type).size());
+
+		for(Segmentationlines::SegmentlineType type : Segmentationlines::getSegmentlineTypes())
+		{
+			const std::size_t typeIndex = static_cast<std::size_t>(type);
+
+			bool lineExists = false;
+			for(const BScan* bscan : bscans)
+				if(bscan && !bscan->getSegmentLineView(type).empty())
+					lineExists = true;
+			if(!lineExists)
+				continue;
+
+			std::vector<std::size_t>& sizes = lineSizes[typeIndex];
+			sizes.assign(numBScans, 0);
+
+			if(precision == Precision::Float)
+				linesFloat[typeIndex].assign(numBScans*numAscans, std::numeric_limits<float>::quiet_NaN());
+			else
+				linesInt16[typeIndex].assign(numBScans*numAscans, invalidInt16);
+
+			for(std::size_t bscanNum = 0; bscanNum < numBScans; ++bscanNum)
+			{
+				if(!bscans[bscanNum])
+					continue;
+
+				const SegmentlineView line = bscans[bscanNum]->getSegmentLineView(type);
+				sizes[bscanNum] = line.size();
+
+				const std::size_t rowOffset = bscanNum*numAscans;
+				if(precision == Precision::Float)
+				{
+					float* row = linesFloat[typeIndex].data() + rowOffset;
+					for(std::size_t ascan = 0; ascan < line.size(); ++ascan)
+						row[ascan] = static_cast<float>(line[ascan]);
+				}
+				else
+				{
+					int16_t* row = linesInt16[typeIndex].data() + rowOffset;
+					for(std::size_t ascan = 0; ascan < line.size(); ++ascan)
+						row[ascan] = toFixedPoint(line[ascan]);
+				}
+			}
+		}
+	}
+
+	bool SegmentationStore::hasSegmentLine(Segmentationlines::SegmentlineType type) const
+	{
+		return !lineSizes[static_cast<std::size_t>(type)].empty();
+	}
+
+	SegmentlineView SegmentationStore::getSegmentLine(Segmentationlines::SegmentlineType type, std::size_t bscan) const
+	{
+		const std::size_t typeIndex = static_cast<std::size_t>(type);
+		const std::vector<std::size_t>& sizes = lineSizes[typeIndex];
+		if(bscan >= sizes.size())
+			return SegmentlineView();
+
+		const std::size_t rowOffset = bscan*numAscans;
+		if(precision == Precision::Float)
+			return SegmentlineView(linesFloat[typeIndex].data() + rowOffset, sizes[bscan]);
+		return SegmentlineView(linesInt16[typeIndex].data() + rowOffset, sizes[bscan], int16Scale);
+	}
+
+	const float* SegmentationStore::getFloatData(Segmentationlines::SegmentlineType type) const
+	{
+		const std::vector<float>& line = linesFloat[static_cast<std::size_t>(type)];
+		if(line.empty())
+			return nullptr;
+		return line.data();
+	}
+
+	std::size_t SegmentationStore::memoryUsage() const
+	{
+		std::size_t bytes = 0;
+		for(std::size_t i = 0; i < numSegmentlineType; ++i)
+			bytes += linesFloat[i].size()*sizeof(float) + linesInt16[i].size()*sizeof(int16_t) + lineSizes[i].size()*sizeof(std::size_t);
+		return bytes;
+	}
+
+}
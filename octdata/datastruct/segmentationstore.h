@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cstdint>
+
+#include "segmentationlines.h"
+
+#ifdef OCTDATA_EXPORT
+	#include "octdata_EXPORTS.h"
+#else
+	#define Octdata_EXPORTS
+#endif
+
+
+namespace OctData
+{
+	class BScan;
+
+	// read only view of a segmentation line, either of the double vector of a B-scan or a row of a SegmentationStore
+	class Octdata_EXPORTS SegmentlineView
+	{
+	public:
+		SegmentlineView() = default;
+		explicit SegmentlineView(const Segmentationlines::Segmentline& line)
+		                                                               : dataDouble(line.data()), numValues(line.size()) {}
+		SegmentlineView(const float* data, std::size_t size)           : dataFloat (data)       , numValues(size) {}
+		SegmentlineView(const int16_t* data, std::size_t size, double scale)
+		                                                               : dataInt16 (data)       , numValues(size), scale(scale) {}
+
+		std::size_t size()                                       const { return numValues;      }
+		bool        empty()                                      const { return numValues == 0; }
+
+		double operator[](std::size_t i) const;
+
+		// direct access to float rows, nullptr for other storage types
+		const float* floatData()                                 const { return dataFloat; }
+
+		Segmentationlines::Segmentline toVector() const;
+
+	private:
+		const double * dataDouble = nullptr;
+		const float  * dataFloat  = nullptr;
+		const int16_t* dataInt16  = nullptr;
+		std::size_t    numValues  = 0;
+		double         scale      = 1.;
+	};
+
+
+	// segmentation of all B-scans of a series, one contiguous array (B-scan x A-scan) per segmentation line
+	class Octdata_EXPORTS SegmentationStore
+	{
+	public:
+		enum class Precision { Float, Int16 };
+
+		static const int16_t invalidInt16 = -32768;                // values out of the fixed-point range, read as NaN
+		static constexpr double int16Scale = 1./16.;               // pixel per fixed-point step, range +-2047 pixel
+
+		SegmentationStore(const std::vector<BScan*>& bscans, Precision precision);
+
+		Precision   getPrecision()                               const { return precision; }
+		std::size_t getNumBScans()                               const { return numBScans; }
+		std::size_t getNumAscans()                               const { return numAscans; }
+
+		bool hasSegmentLine(Segmentationlines::SegmentlineType type) const;
+		SegmentlineView getSegmentLine(Segmentationlines::SegmentlineType type, std::size_t bscan) const;
+
+		// all B-scans of a segmentation line (row stride getNumAscans()), nullptr for Int16 precision or missing lines
+		const float* getFloatData(Segmentationlines::SegmentlineType type) const;
+
+		std::size_t memoryUsage() const;
+
+	private:
+		static const std::size_t numSegmentlineType = Segmentationlines::numSegmentlineType;
+
+		Precision   precision;
+		std::size_t numBScans = 0;
+		std::size_t numAscans = 0;
+
+		std::array<std::vector<float  >, numSegmentlineType> linesFloat;
+		std::array<std::vector<int16_t>, numSegmentlineType> linesInt16;
+		std::array<std::vector<std::size_t>, numSegmentlineType> lineSizes;  // number of valid A-scans per B-scan, empty for missing lines
+	};
+
+}
@@ -19,8 +19,13 @@
 
 #include "bscan.h"
 #include "sloimage.h"
+#include "thicknessmap.h"
+#include "bscanspatialindex.h"
+#include "ascanpositiontable.h"
 
 #include <limits>
+#include <cstdint>
+#include <algorithm>
 
 #define _USE_MATH_DEFINES
 #include <cmath>
@@ -30,8 +35,68 @@
 #include <boost/geometry/geometries/point_xy.hpp>
 #include <boost/geometry/algorithms/assign.hpp>
 
+#include <opencv/cv.hpp>
+
 namespace OctData
 {
+	namespace
+	{
+		const std::size_t packedAlignment = 64;
+
+		// (rows x cols) continuous matrix, the first element is aligned to packedAlignment if the element size allows it
+		cv::Mat allocateAligned(int rows, int cols, int type)
+		{
+			const std::size_t elemSize = CV_ELEM_SIZE(type);
+			const int         padding  = packedAlignment%elemSize == 0 ? static_cast<int>(packedAlignment/elemSize) : 0;
+			const int         numElem  = rows*cols;
+
+			cv::Mat buffer(1, numElem + padding, type);
+
+			int offset = 0;
+			const std::size_t misalign = reinterpret_cast<std::uintptr_t>(buffer.data)%packedAlignment;
+			if(padding > 0 && misalign > 0 && misalign%elemSize == 0)
+				offset = static_cast<int>((packedAlignment - misalign)/elemSize);
+
+			return buffer.colRange(offset, offset + numElem).reshape(0, rows);
+		}
+
+		template<typename GetImage>
+		bool packImages(const Series::BScanList& bscans, cv::Mat& packed, GetImage getImage)
+		{
+			const cv::Mat& first = getImage(*bscans.front());
+			if(first.empty())
+				return false;
+
+			for(const BScan* bscan : bscans)
+			{
+				const cv::Mat& img = getImage(*bscan);
+				if(img.size() != first.size() || img.type() != first.type())
+					return false;
+			}
+
+			const int height = first.rows;
+			packed = allocateAligned(height*static_cast<int>(bscans.size()), first.cols, first.type());
+
+			int row = 0;
+			for(BScan* bscan : bscans)
+			{
+				cv::Mat& img  = getImage(*bscan);
+				cv::Mat  view = packed.rowRange(row, row + height);
+				img.copyTo(view);
+				img  = view;
+				row += height;
+			}
+			return true;
+		}
+	}
+
+	struct Series::PackedImages
+	{
+		cv::Mat image;
+		cv::Mat angioImage;
+		cv::Mat rawImage;
+	};
+
 
 	Series::Series(int internalId)
 	: internalId(internalId)
@@ -47,13 +112,25 @@ namespace OctData
 		for(BScan* bscan : bscans)
 			delete bscan;
 
+		delete packedImages;
+		delete segmentationStore;
 		delete sloImage;
 	}
 
 	void Series::takeBScan(OctData::BScan* bscan)
 	{
+		// the views of the packed B-scans hold the buffers
+		delete packedImages;
+		packedImages = nullptr;
+
 		bscans.push_back(bscan);
-		calculateSLOConvexHull();
+		clearThicknessMaps();
+		{
+			std::lock_guard<std::mutex> lock(spatialIndexMutex);
+			spatialIndex  .reset();
+			ascanPositions.reset();
+		}
+		updateSLOConvexHull();
 		updateCornerCoords();
 	}
 
@@ -64,15 +141,140 @@ namespace OctData
 		return bscans[pos];
 	}
 
+	MemoryUsage Series::memoryUsage() const
+	{
+		MemoryUsage usage;
+		for(const BScan* bscan : bscans)
+			if(bscan)
+				usage += bscan->memoryUsage();
+
+		const cv::Mat& slo = sloImage->getImage();
+		usage.slo = slo.total()*slo.elemSize();
+
+		if(segmentationStore)
+			usage.segmentation += segmentationStore->memoryUsage();
+		return usage;
+	}
+
+	void Series::changeDerivedImageSettings(const std::function<void(DerivedImageSettings&)>& change)
+	{
+		std::vector<DerivedImageSettings*> changed;
+		for(const BScan* bscan : bscans)
+		{
+			DerivedImageSettings* settings = bscan ? bscan->getChangeableDerivedImageSettings() : nullptr;
+			if(!settings || std::find(changed.begin(), changed.end(), settings) != changed.end())
+				continue;
+			change(*settings);
+			changed.push_back(settings);
+		}
+	}
+
+	bool Series::packBScanImages()
+	{
+		if(bscans.empty())
+			return false;
+
+		for(const BScan* bscan : bscans)
+			if(!bscan || bscan->isLazy())
+				return false;
+
+		PackedImages* packed = new PackedImages;
+		if(!packImages(bscans, packed->image, [](const BScan& b) -> cv::Mat& { return *b.image; }))
+		{
+			delete packed;
+			return false;
+		}
+		packImages(bscans, packed->angioImage, [](const BScan& b) -> cv::Mat& { return *b.angioImage; });
+		packImages(bscans, packed->rawImage  , [](const BScan& b) -> cv::Mat& { return *b.rawImage  ; });
+
+		delete packedImages;
+		packedImages = packed;
+		return true;
+	}
+
+	const cv::Mat& Series::getPackedImages(BScanImageType type) const
+	{
+		static const cv::Mat emptyMat;
+		if(!packedImages)
+			return emptyMat;
+
+		switch(type)
+		{
+			case BScanImageType::Image: return packedImages->image;
+			case BScanImageType::Angio: return packedImages->angioImage;
+			case BScanImageType::Raw  : return packedImages->rawImage;
+		}
+		return emptyMat;
+	}
+
+	void Series::packSegmentation(SegmentationStore::Precision precision)
+	{
+		SegmentationStore* store = new SegmentationStore(bscans, precision);
+
+		for(std::size_t i = 0; i < bscans.size(); ++i)
+		{
+			BScan* bscan = bscans[i];
+			if(!bscan)
+				continue;
+
+			bscan->data.segmentationslines = Segmentationlines();
+			bscan->segmentationStore = store;
+			bscan->segmentationIndex = i;
+		}
+
+		delete segmentationStore;
+		segmentationStore = store;
+	}
+
 	void Series::takeSloImage(SloImage* slo)
 	{
 		if(slo)
 		{
 			delete sloImage;
 			sloImage = slo;
+			clearThicknessMaps();
 		}
 	}
 
+	std::shared_ptr<const ThicknessMap> Series::getThicknessMap(Segmentationlines::SegmentlineType from, Segmentationlines::SegmentlineType to) const
+	{
+		const ThicknessMapKey key(from, to);
+		{
+			std::lock_guard<std::mutex> lock(thicknessMapsMutex);
+			std::map<ThicknessMapKey, std::shared_ptr<const ThicknessMap>>::const_iterator it = thicknessMaps.find(key);
+			if(it != thicknessMaps.end())
+				return it->second;
+		}
+
+		// computed without lock, a concurrent request for the same map keeps the first result
+		std::shared_ptr<const ThicknessMap> map = std::make_shared<const ThicknessMap>(*this, from, to);
+
+		std::lock_guard<std::mutex> lock(thicknessMapsMutex);
+		return thicknessMaps.emplace(key, map).first->second;
+	}
+
+	std::shared_ptr<const BScanSpatialIndex> Series::getSpatialIndex() const
+	{
+		std::lock_guard<std::mutex> lock(spatialIndexMutex);
+		if(!spatialIndex)
+			spatialIndex = std::make_shared<const BScanSpatialIndex>(bscans);
+		return spatialIndex;
+	}
+
+	std::shared_ptr<const AscanPositionTable> Series::getAscanPositions() const
+	{
+		std::lock_guard<std::mutex> lock(spatialIndexMutex);
+		if(!ascanPositions)
+			ascanPositions = std::make_shared<const AscanPositionTable>(bscans);
+		return ascanPositions;
+	}
+
+	void Series::clearThicknessMaps()
+	{
+		std::lock_guard<std::mutex> lock(thicknessMapsMutex);
+		thicknessMaps.clear();
+	}
+
 
 
 	void Series::updateCornerCoords(const CoordSLOmm& point)
@@ -117,10 +319,9 @@ namespace OctData
 		}
 	}
 
-	void Series::calculateSLOConvexHull()
+	// the hull of all B-scans is the hull of the previous hull points and the points of the new B-scan
+	void Series::updateSLOConvexHull()
 	{
-		convexHullSLOBScans.clear();
-
 		typedef boost::geometry::model::d2::point_xy<double> Point;
 		typedef boost::geometry::model::polygon<Point> Polygon;
 		typedef std::vector<Point> PointsList;
@@ -142,19 +343,21 @@ namespace OctData
 			}
 		};
 
+		const BScan* bscan = bscans.back();
+		if(!bscan)
+			return;
+
 		PointsList points;
-		for(BScan* bscan : bscans)
+		points.reserve(convexHullSLOBScans.size() + 32);
+		for(const CoordSLOmm& pt : convexHullSLOBScans)
+			Adder::addPoint(points, pt);
+
+		if(bscan->getCenter())
+			Adder::addCircle(points, bscan->getCenter(), bscan->getStart());
+		else
 		{
-			if(bscan)
-			{
-				if(bscan->getCenter())
-					Adder::addCircle(points, bscan->getCenter(), bscan->getStart());
-				else
-				{
-					Adder::addPoint(points, bscan->getStart());
-					Adder::addPoint(points, bscan->getEnd());
-				}
-			}
+			Adder::addPoint(points, bscan->getStart());
+			Adder::addPoint(points, bscan->getEnd());
 		}
 
 		Polygon poly;
@@ -164,6 +367,7 @@ namespace OctData
 		boost::geometry::convex_hull(poly, hull);
 
 		// ring is a vector
+		convexHullSLOBScans.clear();
 		std::vector<Point> const& convexPoints = hull.outer();
 		for(const Point&p : convexPoints)
 			convexHullSLOBScans.emplace_back(p.get<0>(), p.get<1>());
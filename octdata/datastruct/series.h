@@ -20,11 +20,19 @@
 #include <string>
 #include <vector>
 #include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <functional>
 #include "date.h"
 #include "analysegrid.h"
+#include "segmentationstore.h"
+#include "memoryusage.h"
 
 #include"objectwrapper.h"
 
+namespace cv { class Mat; }
+
 
 #ifdef OCTDATA_EXPORT
 	#include "octdata_EXPORTS.h"
@@ -38,6 +46,10 @@ namespace OctData
 {
 	class SloImage;
 	class BScan;
+	class ThicknessMap;
+	class BScanSpatialIndex;
+	class AscanPositionTable;
+	class DerivedImageSettings;
 
 	class Series
 	{
@@ -48,6 +60,7 @@ namespace OctData
 		enum class Laterality        { undef, OD, OS };
 		enum class ScanPattern       { Unknown, Text, SingleLine, Circular, Volume, FastVolume, Radial, RadialCircles };
 		enum class ExaminedStructure { Unknown, Text, ONH, Retina };
+		enum class BScanImageType    { Image, Angio, Raw };
 		typedef ObjectWrapper<Laterality       > LateralityEnumWrapper       ;
 		typedef ObjectWrapper<ScanPattern      > ScanPatternEnumWrapper      ;
 		typedef ObjectWrapper<ExaminedStructure> ExaminedStructureEnumWrapper;
@@ -95,6 +108,32 @@ namespace OctData
 
 		Octdata_EXPORTS void takeBScan(BScan* bscan);
 
+		// copies the images of all B-scans into one contiguous, 64 byte aligned buffer per image type
+		// (rows: bscanCount*height, cols: width), the B-scan images become views into this buffer
+		// returns false for lazy B-scans or B-scan images with different size or type
+		Octdata_EXPORTS bool packBScanImages();
+		Octdata_EXPORTS bool isPacked()                          const { return packedImages != nullptr; }
+		// empty if not packed, valid until the next takeBScan
+		Octdata_EXPORTS const cv::Mat& getPackedImages(BScanImageType type) const;
+
+		// calls change once for every settings object of the derived B-scan images (FileReadOptions::deriveBScanImages),
+		// the settings are shared by the B-scans of the file, a change releases their derived images
+		Octdata_EXPORTS void changeDerivedImageSettings(const std::function<void(DerivedImageSettings&)>& change);
+
+		// moves the segmentation lines of all B-scans into one SegmentationStore,
+		// afterwards the lines are only available by BScan::getSegmentLineView
+		Octdata_EXPORTS void packSegmentation(SegmentationStore::Precision precision);
+		Octdata_EXPORTS const SegmentationStore* getSegmentationStore() const { return segmentationStore; }
+
+		// computed on first request, cached until the B-scans or the SLO image change
+		Octdata_EXPORTS std::shared_ptr<const ThicknessMap> getThicknessMap(Segmentationlines::SegmentlineType from, Segmentationlines::SegmentlineType to) const;
+
+		// B-scan and A-scan lookup by SLO position, built on first request, rebuilt after takeBScan
+		Octdata_EXPORTS std::shared_ptr<const BScanSpatialIndex> getSpatialIndex() const;
+
+		// SLO positions of all A-scans, built on first request, rebuilt after takeBScan
+		Octdata_EXPORTS std::shared_ptr<const AscanPositionTable> getAscanPositions() const;
+
 		Octdata_EXPORTS void setDescription(const std::string& text)   { description = text; }
 		Octdata_EXPORTS const std::string& getDescription()      const { return description; }
 
@@ -103,6 +142,8 @@ namespace OctData
 		Octdata_EXPORTS       AnalyseGrid& getAnalyseGrid()            { return analyseGrid; }
 		Octdata_EXPORTS const AnalyseGrid& getAnalyseGrid()      const { return analyseGrid; }
 
+		Octdata_EXPORTS MemoryUsage memoryUsage() const;
+
 		Octdata_EXPORTS const BScanSLOCoordList& getConvexHull() const { return convexHullSLOBScans; }
 		Octdata_EXPORTS const CoordSLOmm& getLeftUpperCoord()    const { return leftUpper; }
 		Octdata_EXPORTS const CoordSLOmm& getRightLowerCoord()   const { return rightLower; }
@@ -132,12 +173,25 @@ namespace OctData
 
 		BScanList                               bscans;
 
+		struct PackedImages;
+		PackedImages*                           packedImages = nullptr;
+		SegmentationStore*                      segmentationStore = nullptr;
+
+		typedef std::pair<Segmentationlines::SegmentlineType, Segmentationlines::SegmentlineType> ThicknessMapKey;
+		mutable std::map<ThicknessMapKey, std::shared_ptr<const ThicknessMap>> thicknessMaps;
+		mutable std::mutex                      thicknessMapsMutex;
+		void clearThicknessMaps();
+
+		mutable std::shared_ptr<const BScanSpatialIndex>  spatialIndex;
+		mutable std::shared_ptr<const AscanPositionTable> ascanPositions;
+		mutable std::mutex                      spatialIndexMutex;           // for spatialIndex and ascanPositions
+
 		AnalyseGrid                             analyseGrid;
 
 		BScanSLOCoordList                       convexHullSLOBScans;
 		CoordSLOmm                              leftUpper;
 		CoordSLOmm                              rightLower;
-		void calculateSLOConvexHull();
+		void updateSLOConvexHull();
 		void updateCornerCoords();
 		void updateCornerCoords(const CoordSLOmm& point);
 
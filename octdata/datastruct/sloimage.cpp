@@ -41,6 +41,21 @@ namespace OctData
 		*(this->image) = image;
 	}
 
+	void SloImage::mmToPx(const double* xMM, const double* yMM, double* xPx, double* yPx, std::size_t size) const
+	{
+		transform.apply(xMM, yMM, xPx, yPx, size);
+
+		const double scaleX = 1./scaleFactor.getX();
+		const double scaleY = 1./scaleFactor.getY();
+		const double shiftX = shift.getXf();
+		const double shiftY = shift.getYf();
+		for(std::size_t i = 0; i < size; ++i)
+		{
+			xPx[i] = xPx[i]*scaleX + shiftX;
+			yPx[i] = yPx[i]*scaleY + shiftY;
+		}
+	}
+
 	int SloImage::getHeight() const
 	{
 		if(image)
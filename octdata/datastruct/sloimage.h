@@ -85,6 +85,9 @@ namespace OctData
 		int    getImageQuality()                    const           { return imageQuality           ; }
 
 		bool  hasImage()                            const           { return image                  ; }
+
+		// SLO mm to pixel: (transform*mm)*scaleFactor + shift, for size points in separate x and y arrays (in place allowed)
+		Octdata_EXPORTS void mmToPx(const double* xMM, const double* yMM, double* xPx, double* yPx, std::size_t size) const;
 		Octdata_EXPORTS int   getWidth()            const;
 		Octdata_EXPORTS int   getHeight()           const;
 
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sloraster.h"
+
+#include "series.h"
+#include "bscan.h"
+#include "sloimage.h"
+
+#include <opencv/cv.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace OctData
+{
+	namespace
+	{
+		const float invalidValue = std::numeric_limits<float>::quiet_NaN();
+
+		float mix(float a, float b, double t)
+		{
+			if(std::isnan(a))
+				return t < 0.5 ? a : b;
+			if(std::isnan(b))
+				return t < 0.5 ? a : b;
+			return static_cast<float>(a + (b - a)*t);
+		}
+
+		class SloRaster
+		{
+			const SloImage& slo;
+			cv::Mat&        map;
+		public:
+			SloRaster(const SloImage& slo, cv::Mat& map) : slo(slo), map(map) {}
+
+			CoordSLOpx toPx(const CoordSLOmm& mm) const                { return (slo.getTransform()*mm)*slo.getScaleFactor() + slo.getShift(); }
+
+			void set(const CoordSLOpx& px, float value)
+			{
+				const int x = px.getX();
+				const int y = px.getY();
+				if(x >= 0 && y >= 0 && x < map.cols && y < map.rows)
+					map.at<float>(y, x) = value;
+			}
+		};
+
+		// thickness at a fractional position of a row with linear interpolation
+		float sampleRow(const cv::Mat& thickness, int row, int length, double frac)
+		{
+			if(length <= 0)
+				return invalidValue;
+
+			const float* values = thickness.ptr<float>(row);
+			const double pos    = frac*static_cast<double>(length - 1);
+			const int    index  = std::min(static_cast<int>(pos), length - 1);
+			if(index + 1 >= length)
+				return values[index];
+			return mix(values[index], values[index + 1], pos - static_cast<double>(index));
+		}
+
+		std::size_t numSamples(double lengthPx)
+		{
+			return static_cast<std::size_t>(std::ceil(lengthPx)) + 2;
+		}
+
+		double pathLengthPx(const BScan& bscan, const SloRaster& raster)
+		{
+			const int  segments = 32;
+			double     length   = 0;
+			CoordSLOpx last     = raster.toPx(bscan.getFracPos(0));
+			for(int i = 1; i <= segments; ++i)
+			{
+				const CoordSLOpx act = raster.toPx(bscan.getFracPos(static_cast<double>(i)/segments));
+				length += act.abs(last);
+				last = act;
+			}
+			return length;
+		}
+	}
+
+
+	void rasterizeToSlo(const Series& series, const cv::Mat& values, const std::vector<int>& rowLength, cv::Mat& sloMap)
+	{
+		const SloImage& slo      = series.getSloImage();
+		const cv::Mat&  sloImage = slo.getImage();
+		if(sloImage.empty() || values.empty())
+		{
+			sloMap = cv::Mat();
+			return;
+		}
+
+		sloMap = cv::Mat(sloImage.rows, sloImage.cols, cv::DataType<float>::type, cv::Scalar(invalidValue));
+
+		const Series::BScanList bscans = series.getBScans();
+		SloRaster raster(slo, sloMap);
+
+		bool interpolateBScans = bscans.size() > 1
+		                      && (series.getScanPattern() == Series::ScanPattern::Volume || series.getScanPattern() == Series::ScanPattern::FastVolume);
+		for(const BScan* bscan : bscans)
+			if(!bscan || bscan->getBScanType() != BScan::BScanType::Line)
+				interpolateBScans = false;
+
+		if(interpolateBScans)
+		{
+			// bilinear between neighbouring B-scans, sampled with less than one pixel distance
+			for(std::size_t i = 0; i + 1 < bscans.size(); ++i)
+			{
+				const BScan& first  = *bscans[i    ];
+				const BScan& second = *bscans[i + 1];
+
+				const CoordSLOpx firstStart  = raster.toPx(first .getStart());
+				const CoordSLOpx firstEnd    = raster.toPx(first .getEnd  ());
+				const CoordSLOpx secondStart = raster.toPx(second.getStart());
+				const CoordSLOpx secondEnd   = raster.toPx(second.getEnd  ());
+
+				const std::size_t numU = numSamples(std::max(firstStart.abs(firstEnd), secondStart.abs(secondEnd)));
+				const std::size_t numV = numSamples(std::max(firstStart.abs(secondStart), firstEnd.abs(secondEnd)));
+
+				for(std::size_t u = 0; u < numU; ++u)
+				{
+					const double     fracU      = static_cast<double>(u)/static_cast<double>(numU - 1);
+					const CoordSLOpx firstPos   = firstStart *(1 - fracU) + firstEnd *fracU;
+					const CoordSLOpx secondPos  = secondStart*(1 - fracU) + secondEnd*fracU;
+					const float      firstVal   = sampleRow(values, static_cast<int>(i    ), rowLength[i    ], fracU);
+					const float      secondVal  = sampleRow(values, static_cast<int>(i + 1), rowLength[i + 1], fracU);
+
+					for(std::size_t v = 0; v < numV; ++v)
+					{
+						const double fracV = static_cast<double>(v)/static_cast<double>(numV - 1);
+						raster.set(firstPos*(1 - fracV) + secondPos*fracV, mix(firstVal, secondVal, fracV));
+					}
+				}
+			}
+		}
+		else
+		{
+			for(std::size_t i = 0; i < bscans.size(); ++i)
+			{
+				if(!bscans[i])
+					continue;
+
+				const BScan&      bscan = *bscans[i];
+				const std::size_t numU  = numSamples(pathLengthPx(bscan, raster));
+				for(std::size_t u = 0; u < numU; ++u)
+				{
+					const double fracU = static_cast<double>(u)/static_cast<double>(numU - 1);
+					raster.set(raster.toPx(bscan.getFracPos(fracU)), sampleRow(values, static_cast<int>(i), rowLength[i], fracU));
+				}
+			}
+		}
+	}
+
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <vector>
+
+namespace cv { class Mat; }
+
+namespace OctData
+{
+	class Series;
+
+	// draws per A-scan values (CV_32F, one row per B-scan, rowLength valid values per row) in the pixel grid of the SLO image,
+	// volume scans are interpolated bilinear between neighbouring B-scans, other scan patterns along the B-scan path,
+	// pixels without value are NaN, sloMap is empty if the series has no SLO image
+	void rasterizeToSlo(const Series& series, const cv::Mat& values, const std::vector<int>& rowLength, cv::Mat& sloMap);
+}
@@ -19,6 +19,8 @@
 
 #include <map>
 
+#include "memoryusage.h"
+
 
 #ifdef OCTDATA_EXPORT
 	#include "octdata_EXPORTS.h"
@@ -54,6 +56,14 @@ namespace OctData
 		Octdata_EXPORTS SubstructureIterator  end()                             { return substructureMap.end();   }
 		Octdata_EXPORTS std::size_t size()            const                     { return substructureMap.size();  }
 
+		Octdata_EXPORTS MemoryUsage memoryUsage() const
+		{
+			MemoryUsage usage;
+			for(const SubstructurePair& obj : substructureMap)
+				usage += obj.second->memoryUsage();
+			return usage;
+		}
+
 	protected:
 		void swapSubstructure(SubstructureTemplate& d)          { substructureMap.swap(d.substructureMap); }
 
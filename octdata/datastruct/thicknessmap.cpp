@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "thicknessmap.h"
+
+#include "series.h"
+#include "bscan.h"
+#include "sloraster.h"
+#include "../import/threadpool.h"
+
+#include <opencv/cv.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace OctData
+{
+	namespace
+	{
+		const float invalidThickness = std::numeric_limits<float>::quiet_NaN();
+
+		// branch free, NaN in one of the lines propagates to the result
+		void thicknessKernel(const float* from, const float* to, float* out, std::size_t size, float scale)
+		{
+			for(std::size_t i = 0; i < size; ++i)
+				out[i] = (to[i] - from[i])*scale;
+		}
+
+		const float* floatLine(const SegmentlineView& view, std::vector<float>& buffer)
+		{
+			if(view.floatData())
+				return view.floatData();
+
+			buffer.resize(view.size());
+			for(std::size_t i = 0; i < view.size(); ++i)
+				buffer[i] = static_cast<float>(view[i]);
+			return buffer.data();
+		}
+	}
+
+
+	ThicknessMap::ThicknessMap(const Series& series, Segmentationlines::SegmentlineType from, Segmentationlines::SegmentlineType to)
+	: from(from)
+	, to  (to  )
+	, bscanThickness(new cv::Mat)
+	, sloMap        (new cv::Mat)
+	{
+		calcBScanThickness(series);
+		calcSloMap(series);
+	}
+
+	ThicknessMap::~ThicknessMap()
+	{
+		delete bscanThickness;
+		delete sloMap;
+	}
+
+	void ThicknessMap::calcBScanThickness(const Series& series)
+	{
+		const Series::BScanList bscans = series.getBScans();
+
+		std::size_t numAscans = 0;
+		for(const BScan* bscan : bscans)
+			if(bscan)
+				numAscans = std::max(numAscans, std::min(bscan->getSegmentLineView(from).size(), bscan->getSegmentLineView(to).size()));
+
+		*bscanThickness = cv::Mat(static_cast<int>(bscans.size()), static_cast<int>(numAscans), cv::DataType<float>::type, cv::Scalar(invalidThickness));
+		if(bscans.empty() || numAscans == 0)
+			return;
+
+		auto calcRows = [this, &bscans](std::size_t begin, std::size_t end)
+		{
+			std::vector<float> fromBuffer;
+			std::vector<float> toBuffer;
+			for(std::size_t row = begin; row < end; ++row)
+			{
+				const BScan* bscan = bscans[row];
+				if(!bscan)
+					continue;
+
+				const SegmentlineView fromLine = bscan->getSegmentLineView(from);
+				const SegmentlineView toLine   = bscan->getSegmentLineView(to  );
+				const std::size_t     size     = std::min(fromLine.size(), toLine.size());
+				const double          scaleZ   = bscan->getScaleFactor().getZ();
+
+				thicknessKernel(floatLine(fromLine, fromBuffer)
+				              , floatLine(toLine  , toBuffer  )
+				              , bscanThickness->ptr<float>(static_cast<int>(row))
+				              , size
+				              , static_cast<float>(scaleZ > 0 ? scaleZ : 1.));
+			}
+		};
+
+		ThreadPool::parallelFor(bscans.size(), 16, calcRows);
+	}
+
+	void ThicknessMap::calcSloMap(const Series& series)
+	{
+		const Series::BScanList bscans = series.getBScans();
+
+		std::vector<int> rowLength(bscans.size(), 0);
+		for(std::size_t i = 0; i < bscans.size(); ++i)
+			if(bscans[i])
+				rowLength[i] = static_cast<int>(std::min(bscans[i]->getSegmentLineView(from).size(), bscans[i]->getSegmentLineView(to).size()));
+
+		rasterizeToSlo(series, *bscanThickness, rowLength, *sloMap);
+	}
+
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include "segmentationlines.h"
+
+namespace cv { class Mat; }
+
+#ifdef OCTDATA_EXPORT
+	#include "octdata_EXPORTS.h"
+#else
+	#define Octdata_EXPORTS
+#endif
+
+
+namespace OctData
+{
+	class Series;
+
+	// thickness between two segmentation lines of a series (to - from, mm if the B-scans have a z scale factor, else pixel)
+	// NaN where one of the lines is missing
+	class ThicknessMap
+	{
+	public:
+		Octdata_EXPORTS ThicknessMap(const Series& series, Segmentationlines::SegmentlineType from, Segmentationlines::SegmentlineType to);
+		Octdata_EXPORTS ~ThicknessMap();
+
+		ThicknessMap(const ThicknessMap&)            = delete;
+		ThicknessMap& operator=(const ThicknessMap&) = delete;
+
+		Segmentationlines::SegmentlineType getFrom()             const { return from; }
+		Segmentationlines::SegmentlineType getTo()               const { return to;   }
+
+		// CV_32F, one row per B-scan, one column per A-scan
+		const cv::Mat& getBScanThickness()                       const { return *bscanThickness; }
+		// CV_32F in the pixel grid of the SLO image, empty if the series has no SLO image
+		const cv::Mat& getSloMap()                               const { return *sloMap; }
+
+	private:
+		Segmentationlines::SegmentlineType from;
+		Segmentationlines::SegmentlineType to;
+
+		cv::Mat* bscanThickness = nullptr;
+		cv::Mat* sloMap         = nullptr;
+
+		void calcBScanThickness(const Series& series);
+		void calcSloMap(const Series& series);
+	};
+
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "derivedimagesettings.h"
+
+#include <algorithm>
+
+#include <datastruct/bscanimagecache.h>
+
+namespace OctData
+{
+	DerivedImageSettings::DerivedImageSettings(const FileReadOptions& op)
+	: e2eGray            (op.e2eGray)
+	, fillEmptyPixelWhite(op.fillEmptyPixelWhite)
+	, cache              (std::make_shared<BScanImageCache>(static_cast<std::size_t>(std::max(op.lazyCacheSizeMB, 1))*1024*1024))
+	{
+	}
+
+	FileReadOptions::E2eGrayTransform DerivedImageSettings::getE2eGray() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return e2eGray;
+	}
+
+	bool DerivedImageSettings::getFillEmptyPixelWhite() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return fillEmptyPixelWhite;
+	}
+
+	// the loaders read the settings under the lock of the cache, clear() waits for a running derivation
+	void DerivedImageSettings::setE2eGray(FileReadOptions::E2eGrayTransform gray)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if(e2eGray == gray)
+				return;
+			e2eGray = gray;
+		}
+		cache->clear();
+	}
+
+	void DerivedImageSettings::setFillEmptyPixelWhite(bool fill)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if(fillEmptyPixelWhite == fill)
+				return;
+			fillEmptyPixelWhite = fill;
+		}
+		cache->clear();
+	}
+}
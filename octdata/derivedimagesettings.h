@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+#include "filereadoptions.h"
+
+#ifdef OCTDATA_EXPORT
+	#include "octdata_EXPORTS.h"
+#else
+	#define Octdata_EXPORTS
+#endif
+
+namespace OctData
+{
+	class BScanImageCache;
+
+	// settings of the B-scan images derived from the raw images (FileReadOptions::deriveBScanImages)
+	// shared by the B-scans of one file together with their image cache (BScan::getDerivedImageSettings, Series::changeDerivedImageSettings),
+	// a change releases the derived images, the next access derives them with the new settings, the file is not read again
+	class Octdata_EXPORTS DerivedImageSettings
+	{
+		FileReadOptions::E2eGrayTransform e2eGray;
+		bool                              fillEmptyPixelWhite;
+		std::shared_ptr<BScanImageCache>  cache;
+		mutable std::mutex                mutex;
+
+		DerivedImageSettings(const DerivedImageSettings&)            = delete;
+		DerivedImageSettings& operator=(const DerivedImageSettings&) = delete;
+
+	public:
+		explicit DerivedImageSettings(const FileReadOptions& op);
+
+		FileReadOptions::E2eGrayTransform getE2eGray()            const;
+		bool getFillEmptyPixelWhite()                               const;
+
+		void setE2eGray(FileReadOptions::E2eGrayTransform gray);
+		void setFillEmptyPixelWhite(bool fill);
+
+		// holds the derived images, limited by FileReadOptions::lazyCacheSizeMB
+		const std::shared_ptr<BScanImageCache>& getCache()           const { return cache; }
+	};
+}
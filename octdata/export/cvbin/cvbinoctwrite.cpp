@@ -81,9 +81,12 @@ namespace OctData
 
 			for(OctData::Segmentationlines::SegmentlineType type : OctData::Segmentationlines::getSegmentlineTypes())
 			{
-				const Segmentationlines::Segmentline& seg = bscan->getSegmentLine(type);
-				if(!seg.empty())
+				const SegmentlineView segView = bscan->getSegmentLineView(type);
+				if(!segView.empty())
+				{
+					const Segmentationlines::Segmentline seg = segView.toVector();
 					bscanSegNode.getDirNode(Segmentationlines::getSegmentlineName(type)).getMat() = cv::Mat(1, static_cast<int>(seg.size()), cv::DataType<Segmentationlines::SegmentlineDataType>::type, const_cast<Segmentationlines::SegmentlineDataType*>(seg.data())).clone();
+				}
 			}
 		}
 
@@ -157,14 +157,14 @@ namespace OctData
 			}
 
 
-			void writeSegmentation(bpt::ptree& segNode, const Segmentationlines& seglines)
+			void writeSegmentation(bpt::ptree& segNode, const BScan& bscan)
 			{
 				SetToPTree set(segNode);
 				for(OctData::Segmentationlines::SegmentlineType type : OctData::Segmentationlines::getSegmentlineTypes())
 				{
-					const Segmentationlines::Segmentline& seg = seglines.getSegmentLine(type);
+					const SegmentlineView seg = bscan.getSegmentLineView(type);
 					if(!seg.empty())
-						set(Segmentationlines::getSegmentlineName(type), seg);
+						set(Segmentationlines::getSegmentlineName(type), seg.toVector());
 				}
 			}
 
@@ -183,7 +183,7 @@ namespace OctData
 
 
 				bpt::ptree seglinesTree;
-				writeSegmentation(seglinesTree.add("LayerSegmentation", ""), bscan->getSegmentLines());
+				writeSegmentation(seglinesTree.add("LayerSegmentation", ""), *bscan);
 
 				std::string segmentationFile = dataPath + "segmentation_" + numString + ".xml";
 				writeXml(segmentationFile, seglinesTree);
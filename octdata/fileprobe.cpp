@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "fileprobe.h"
+
+#include <datastruct/oct.h>
+#include <datastruct/bscan.h>
+#include <datastruct/sloimage.h>
+
+
+namespace OctData
+{
+
+	FileProbe::SeriesInfo& FileProbe::addSeries(const Patient& patient, const Study& study, const Series& seriesData)
+	{
+		series.emplace_back();
+		SeriesInfo& info = series.back();
+
+		info.patientId       = patient.getId();
+		info.patientUID      = patient.getPatientUID();
+		info.studyUID        = study.getStudyUID();
+		info.studyDate       = study.getStudyDate();
+		info.seriesUID       = seriesData.getSeriesUID();
+		info.laterality      = seriesData.getLaterality();
+		info.scanPattern     = seriesData.getScanPattern();
+		info.scanPatternText = seriesData.getScanPatternText();
+		info.scanDate        = seriesData.getScanDate();
+		info.bscanCount      = seriesData.bscanCount();
+
+		const BScan* bscan = seriesData.getBScan(0);
+		if(bscan)
+		{
+			info.bscanWidth  = static_cast<std::size_t>(bscan->getWidth ());
+			info.bscanHeight = static_cast<std::size_t>(bscan->getHeight());
+		}
+
+		const SloImage& slo = seriesData.getSloImage();
+		info.sloWidth  = static_cast<std::size_t>(slo.getWidth ());
+		info.sloHeight = static_cast<std::size_t>(slo.getHeight());
+
+		return info;
+	}
+
+	void FileProbe::addOCT(const OCT& oct)
+	{
+		for(const OCT::SubstructurePair& patientPair : oct)
+			for(const Patient::SubstructurePair& studyPair : *patientPair.second)
+				for(const Study::SubstructurePair& seriesPair : *studyPair.second)
+					addSeries(*patientPair.second, *studyPair.second, *seriesPair.second);
+	}
+
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "datastruct/date.h"
+#include "datastruct/series.h"
+
+#ifdef OCTDATA_EXPORT
+	#include "octdata_EXPORTS.h"
+#else
+	#define Octdata_EXPORTS
+#endif
+
+namespace OctData
+{
+	class OCT;
+	class Patient;
+	class Study;
+
+	// lightweight summary of a file, filled from the file headers without decoding pixel data
+	class FileProbe
+	{
+	public:
+		struct SeriesInfo
+		{
+			std::string         patientId  ;
+			std::string         patientUID ;
+			std::string         studyUID   ;
+			std::string         seriesUID  ;
+			Series::Laterality  laterality  = Series::Laterality::undef;
+			Series::ScanPattern scanPattern = Series::ScanPattern::Unknown;
+			std::string         scanPatternText;
+			Date                studyDate  ;
+			Date                scanDate   ;
+
+			// 0 if the value is not known from the headers
+			std::size_t         bscanCount  = 0;
+			std::size_t         bscanWidth  = 0;               // A-scans per B-scan
+			std::size_t         bscanHeight = 0;               // pixels per A-scan
+			std::size_t         sloWidth    = 0;
+			std::size_t         sloHeight   = 0;
+		};
+
+		typedef std::vector<SeriesInfo> SeriesInfoList;
+
+		std::string    format;                                  // name of the reader that probed the file
+		SeriesInfoList series;
+
+		bool empty()                                       const { return series.empty(); }
+
+		// metadata of the given structures, the image sizes from the B-scans and SLO images contained
+		Octdata_EXPORTS SeriesInfo& addSeries(const Patient& patient, const Study& study, const Series& series);
+		Octdata_EXPORTS void addOCT(const OCT& oct);
+	};
+}
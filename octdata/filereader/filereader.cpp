@@ -17,10 +17,20 @@
 
 #include "filereader.h"
 
+#include<algorithm>
+
 #include<boost/endian/conversion.hpp>
 
+#include<boost/interprocess/exceptions.hpp>
+#include<boost/log/trivial.hpp>
+
+#include<system_error>
+
 #include"filestreamdircet.h"
+#include"filestreammmap.h"
 #include"filestreamgzip.h"
+#include"filestreamuring.h"
+#include"../filereadoptions.h"
 #include <import/platform_helper.h>
 
 namespace bfs = boost::filesystem;
@@ -44,29 +54,83 @@ namespace OctData
 		}
 	}
 
+	FileReader::FileReader(const boost::filesystem::path& filepath, const FileReadOptions& op)
+	: FileReader(filepath)
+	{
+		gzipIndexFile = op.gzipIndexFile;
+		ioUring       = op.ioUring;
+	}
+
 	FileReader::~FileReader()
 	{
 		delete fileStream;
+
+#ifdef WITH_ZLIB
+		if(gzipIndexFile && gzipIndex && gzipIndex->isComplete() && gzipIndex->isModified())
+			gzipIndex->writeIndexFile(filepath);
+#endif
 	}
 
-	bool OctData::FileReader::openFile()
+	bool OctData::FileReader::openFile(bool useMemoryMap)
 	{
 		delete fileStream;
 		fileStream = nullptr;
 		switch(compressType)
 		{
 			case Compressed::none:
-				fileStream = new FileStreamDircet(filepath);
+#ifdef WITH_IO_URING
+				if(ioUring)
+				{
+					try
+					{
+						fileStream = new FileStreamURing(filepath);
+					}
+					catch(const std::system_error& e)
+					{
+						BOOST_LOG_TRIVIAL(debug) << "Can't use io_uring for " << filepath.generic_string() << ": " << e.what();
+					}
+				}
+#endif
+				if(!fileStream && useMemoryMap)
+				{
+					try
+					{
+						fileStream = new FileStreamMMap(filepath);
+					}
+					catch(const boost::interprocess::interprocess_exception& e)
+					{
+						BOOST_LOG_TRIVIAL(debug) << "Can't map file " << filepath.generic_string() << ": " << e.what() << ", use file stream";
+					}
+				}
+				if(!fileStream)
+					fileStream = new FileStreamDircet(filepath);
 				break;
 			case Compressed::gzip:
 #ifdef WITH_ZLIB
-				fileStream = new FileStreamGZip(filepath);
+				if(!gzipIndex)
+				{
+					gzipIndex = std::make_shared<GZipIndex>();
+					if(gzipIndexFile)
+						gzipIndex->readIndexFile(filepath);
+				}
+				fileStream = new FileStreamGZip(filepath, gzipIndex);
 #endif
 				break;
 		}
 		return fileStream != nullptr;
 	}
 
+	std::string FileReader::readHeader(std::size_t size)
+	{
+		if(!openFile())
+			return std::string();
+
+		std::string header(size, '\0');
+		const std::streamsize readBytes = fileStream->read(&header[0], static_cast<std::streamsize>(size));
+		header.resize(static_cast<std::size_t>(std::max(readBytes, static_cast<std::streamsize>(0))));
+		return header;
+	}
+
 	std::size_t FileReader::file_size() const
 	{
 		if(filesize == 0)
@@ -77,6 +141,13 @@ namespace OctData
 					filesize = bfs::file_size(filepath);
 					break;
 				case Compressed::gzip:
+#ifdef WITH_ZLIB
+					if(gzipIndex && gzipIndex->isComplete())
+					{
+						filesize = static_cast<std::size_t>(gzipIndex->uncompressedSize());
+						break;
+					}
+#endif
 					std::ifstream stream(filepathConv(filepath), std::ios::binary | std::ios::in);
 					stream.seekg(-4, std::ios_base::end);
 					unsigned int size;
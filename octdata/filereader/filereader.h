@@ -26,9 +26,14 @@
 
 
 #include<iostream>
+#include<memory>
+#include<string>
+#include<vector>
 
 namespace OctData
 {
+	class FileReadOptions;
+	class GZipIndex;
 	class FileStreamInterface
 	{
 	public:
@@ -39,6 +44,34 @@ namespace OctData
 		virtual void seekg(std::streamoff pos) = 0;
 
 		virtual bool good() const = 0;
+
+		// pointer to the next size bytes without copying them (advances the read position),
+		// nullptr if the stream is not memory mapped
+		virtual const char* getMappedData(std::streamsize /*size*/)   { return nullptr; }
+		virtual bool isMemoryMapped()                            const { return false; }
+
+		struct ReadRequest
+		{
+			std::streamoff  offset;
+			std::streamsize size;
+			char*           dest;
+		};
+
+		// reads all requests (the position after the call is undefined)
+		// returns the number of requests from the front which are read completely
+		virtual std::size_t readBatch(const std::vector<ReadRequest>& requests)
+		{
+			std::size_t numRead = 0;
+			for(const ReadRequest& request : requests)
+			{
+				seekg(request.offset);
+				read(request.dest, request.size);
+				if(!good())
+					break;
+				++numRead;
+			}
+			return numRead;
+		}
 	};
 
 	class FileReader
@@ -54,6 +87,10 @@ namespace OctData
 
 		FileStreamInterface* fileStream = nullptr;
 
+		std::shared_ptr<GZipIndex> gzipIndex;                      // kept over reopening the file
+		bool                       gzipIndexFile = false;
+		bool                       ioUring       = false;
+
 		template<typename T>
 		void readFStreamBigInt(T* dest, std::size_t num, std::true_type)
 		{
@@ -76,17 +113,30 @@ namespace OctData
 
 
 	public:
+		typedef FileStreamInterface::ReadRequest ReadRequest;
+
 		FileReader(const boost::filesystem::path& filepath);
+		FileReader(const boost::filesystem::path& filepath, const FileReadOptions& op);
 		~FileReader();
 
 		const boost::filesystem::path& getFilepath()             const { return filepath; }
 		const boost::filesystem::path& getExtension()            const { return extension; }
 
 
-		bool openFile();
+		bool openFile(bool useMemoryMap = false);
+		// up to size bytes from the begin of the (uncompressed) file, used to detect the file format
+		std::string readHeader(std::size_t size);
 		void seekg(std::streamoff pos)                                 { fileStream->seekg(pos); }
 		bool good()                                              const { return fileStream->good(); }
 		std::size_t file_size()                                  const;
+		bool isMemoryMapped()                                    const { return fileStream->isMemoryMapped(); }
+
+
+		// pointer to size bytes at pos without copying them, nullptr if the file is not memory mapped
+		const char* getMappedData(std::streamoff pos, std::size_t size){ fileStream->seekg(pos); return fileStream->getMappedData(static_cast<std::streamsize>(size)); }
+
+		// see FileStreamInterface::readBatch, with io_uring the requests are submitted together
+		std::size_t readBatch(const std::vector<ReadRequest>& requests){ return fileStream->readBatch(requests); }
 
 
 		template<typename T>
@@ -112,5 +162,35 @@ namespace OctData
 			fileStream->read(reinterpret_cast<char*>(image.data), sizeof(T)*num);
 // 			stream.read(reinterpret_cast<char*>(image.data), num*sizeof(T));
 		}
+
+		// reads num images, the first at pos and the following each stride bytes later, in one batch
+		// returns the number of completely read images
+		template<typename T>
+		std::size_t readCVImageBatch(std::vector<cv::Mat>& images, std::streamoff pos, std::streamoff stride, std::size_t num, std::size_t sizeX, std::size_t sizeY)
+		{
+			images.resize(num);
+			std::vector<ReadRequest> requests(num);
+			for(std::size_t i = 0; i < num; ++i)
+			{
+				images[i] = cv::Mat(static_cast<int>(sizeX), static_cast<int>(sizeY), cv::DataType<T>::type);
+				requests[i].offset = pos + static_cast<std::streamoff>(i)*stride;
+				requests[i].size   = static_cast<std::streamsize>(sizeof(T)*sizeX*sizeY);
+				requests[i].dest   = reinterpret_cast<char*>(images[i].data);
+			}
+			return readBatch(requests);
+		}
+
+		// like readCVImage, but for a memory mapped file the image header points directly into the mapped pages (no copy)
+		// the image is only valid as long as the FileReader exists, use clone() to keep the data
+		template<typename T>
+		void readCVImageView(cv::Mat& image, std::size_t sizeX, std::size_t sizeY)
+		{
+			const std::size_t num = sizeX*sizeY;
+			const char* mappedData = fileStream->getMappedData(static_cast<std::streamsize>(sizeof(T)*num));
+			if(mappedData)
+				image = cv::Mat(static_cast<int>(sizeX), static_cast<int>(sizeY), cv::DataType<T>::type, const_cast<char*>(mappedData));
+			else
+				readCVImage<T>(image, sizeX, sizeY);
+		}
 	};
 }
@@ -31,7 +31,7 @@ namespace OctData
 
 
 		virtual std::streamsize read(char* dest, std::streamsize size) override
-		                                                               { stream.read(dest, size); return size; }
+		                                                               { stream.read(dest, size); return stream.gcount(); }
 		virtual void seekg(std::streamoff pos) override                { stream.seekg(pos); }
 
 		bool good()                                     const override { return stream.good(); }
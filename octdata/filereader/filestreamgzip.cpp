@@ -20,19 +20,412 @@
 
 #ifdef WITH_ZLIB
 
+#include <algorithm>
+#include <cstring>
+
+#include <boost/endian/arithmetic.hpp>
+#include <boost/log/trivial.hpp>
+
+#include <import/platform_helper.h>
+
+namespace bfs = boost::filesystem;
+
+namespace
+{
+	const std::size_t inBufferSize = 128*1024;
+	const char        indexMagic[8] = { 'O', 'C', 'T', 'G', 'Z', 'I', 'D', 'X' };
+	const std::uint32_t indexVersion = 1;
+
+	struct IndexFileHeader
+	{
+		char                           magic[8];
+		boost::endian::little_uint32_t version;
+		boost::endian::little_uint32_t windowSize;
+		boost::endian::little_uint64_t sourceSize;
+		boost::endian::little_int64_t  sourceTime;
+		boost::endian::little_uint64_t span;
+		boost::endian::little_uint64_t totalOut;
+		boost::endian::little_uint64_t numPoints;
+	};
+
+	struct IndexFilePoint
+	{
+		boost::endian::little_uint64_t out;
+		boost::endian::little_uint64_t in;
+		boost::endian::little_uint32_t bits;
+	};
+
+	bool getSourceInfo(const bfs::path& gzipFile, std::uint64_t& size, std::int64_t& time)
+	{
+		boost::system::error_code ec;
+		size = bfs::file_size(gzipFile, ec);
+		if(ec)
+			return false;
+		time = static_cast<std::int64_t>(bfs::last_write_time(gzipFile, ec));
+		return !ec;
+	}
+}
+
+
 namespace OctData
 {
+	const std::size_t GZipIndex::windowSize;
+	const std::size_t GZipIndex::defaultSpan;
+
+	const GZipIndex::AccessPoint* GZipIndex::findAccessPoint(std::uint64_t out) const
+	{
+		auto it = std::upper_bound(points.begin(), points.end(), out, [](std::uint64_t value, const AccessPoint& p) { return value < p.out; });
+		if(it == points.begin())
+			return nullptr;
+		return &*(it-1);
+	}
+
+	void GZipIndex::addAccessPoint(std::uint64_t out, std::uint64_t in, int bits, const unsigned char* window, std::size_t windowPos)
+	{
+		points.emplace_back();
+		AccessPoint& point = points.back();
+		point.out  = out;
+		point.in   = in;
+		point.bits = bits;
+
+		// the window is a ring buffer, store the bytes in stream order
+		point.window.resize(windowSize);
+		std::copy(window + windowPos, window + windowSize, point.window.begin());
+		std::copy(window, window + windowPos, point.window.begin() + static_cast<std::ptrdiff_t>(windowSize - windowPos));
+
+		modified = true;
+	}
+
+	void GZipIndex::setComplete(std::uint64_t totalOut)
+	{
+		if(complete)
+			return;
+		this->totalOut = totalOut;
+		complete = true;
+		modified = true;
+	}
+
+	bfs::path GZipIndex::indexFilepath(const bfs::path& gzipFile)
+	{
+		bfs::path indexFile = gzipFile;
+		indexFile += ".gzidx";
+		return indexFile;
+	}
+
+	bool GZipIndex::readIndexFile(const bfs::path& gzipFile)
+	{
+		const bfs::path indexFile = indexFilepath(gzipFile);
+		if(!bfs::exists(indexFile))
+			return false;
+
+		std::uint64_t sourceSize;
+		std::int64_t  sourceTime;
+		if(!getSourceInfo(gzipFile, sourceSize, sourceTime))
+			return false;
+
+		std::ifstream stream(filepathConv(indexFile), std::ios::binary | std::ios::in);
+		IndexFileHeader header;
+		stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+		if(!stream.good()
+		|| std::memcmp(header.magic, indexMagic, sizeof(indexMagic)) != 0
+		|| header.version    != indexVersion
+		|| header.windowSize != windowSize
+		|| header.sourceSize != sourceSize
+		|| header.sourceTime != sourceTime)
+		{
+			BOOST_LOG_TRIVIAL(info) << "ignore outdated or invalid gzip index " << indexFile.generic_string();
+			return false;
+		}
+
+		// every access point is stored with its window, a corrupt numPoints must not size the allocation
+		boost::system::error_code ec;
+		const boost::uintmax_t indexSize = bfs::file_size(indexFile, ec);
+		const std::uint64_t    pointSize = sizeof(IndexFilePoint) + windowSize;
+		if(ec || indexSize < sizeof(header) || header.numPoints != (indexSize - sizeof(header))/pointSize)
+		{
+			BOOST_LOG_TRIVIAL(warning) << "broken gzip index " << indexFile.generic_string();
+			return false;
+		}
 
-	FileStreamGZip::FileStreamGZip(const boost::filesystem::path& filepath)
+		std::vector<AccessPoint> readPoints(static_cast<std::size_t>(header.numPoints));
+		for(AccessPoint& point : readPoints)
+		{
+			IndexFilePoint filePoint;
+			stream.read(reinterpret_cast<char*>(&filePoint), sizeof(filePoint));
+			point.out  = filePoint.out;
+			point.in   = filePoint.in;
+			point.bits = static_cast<int>(filePoint.bits);
+			point.window.resize(windowSize);
+			stream.read(reinterpret_cast<char*>(point.window.data()), windowSize);
+			if(!stream.good() || point.bits > 7 || point.in > sourceSize)
+			{
+				BOOST_LOG_TRIVIAL(warning) << "broken gzip index " << indexFile.generic_string();
+				return false;
+			}
+		}
+
+		points   = std::move(readPoints);
+		span     = static_cast<std::size_t>(header.span);
+		totalOut = header.totalOut;
+		complete = true;
+		modified = false;
+
+		BOOST_LOG_TRIVIAL(debug) << "read gzip index " << indexFile.generic_string() << " with " << points.size() << " access points";
+		return true;
+	}
+
+	bool GZipIndex::writeIndexFile(const bfs::path& gzipFile)
 	{
-		file = gzopen(filepath.generic_string().c_str(), "r");
-		gzbuffer(file, 128*1024);
+		if(!complete)
+			return false;
+
+		IndexFileHeader header;
+		std::uint64_t sourceSize;
+		std::int64_t  sourceTime;
+		if(!getSourceInfo(gzipFile, sourceSize, sourceTime))
+			return false;
+
+		std::memcpy(header.magic, indexMagic, sizeof(indexMagic));
+		header.version    = indexVersion;
+		header.windowSize = static_cast<std::uint32_t>(windowSize);
+		header.sourceSize = sourceSize;
+		header.sourceTime = sourceTime;
+		header.span       = span;
+		header.totalOut   = totalOut;
+		header.numPoints  = points.size();
+
+		const bfs::path indexFile = indexFilepath(gzipFile);
+		std::ofstream stream(filepathConv(indexFile), std::ios::binary | std::ios::out);
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		for(const AccessPoint& point : points)
+		{
+			IndexFilePoint filePoint;
+			filePoint.out  = point.out;
+			filePoint.in   = point.in;
+			filePoint.bits = static_cast<std::uint32_t>(point.bits);
+			stream.write(reinterpret_cast<const char*>(&filePoint), sizeof(filePoint));
+			stream.write(reinterpret_cast<const char*>(point.window.data()), windowSize);
+		}
+
+		if(!stream.good())
+		{
+			BOOST_LOG_TRIVIAL(warning) << "can't write gzip index " << indexFile.generic_string();
+			stream.close();
+			boost::system::error_code ec;
+			bfs::remove(indexFile, ec);
+			return false;
+		}
+
+		modified = false;
+		return true;
+	}
+
+
+
+	FileStreamGZip::FileStreamGZip(const bfs::path& filepath, std::shared_ptr<GZipIndex> index)
+	: file(filepathConv(filepath), std::ios::binary | std::ios::in)
+	, index(index)
+	, inBuffer(inBufferSize)
+	{
+		if(!this->index)
+			this->index = std::make_shared<GZipIndex>();
+
+		std::memset(&strm, 0, sizeof(strm));
+		if(inflateInit2(&strm, 15 + 16) != Z_OK)                   // +16: gzip header
+		{
+			BOOST_LOG_TRIVIAL(error) << "inflateInit2 failed: " << (strm.msg ? strm.msg : "");
+			isGood = false;
+			return;
+		}
+
+		isGood = file.good() && restart(nullptr);
 	}
 
 	FileStreamGZip::~FileStreamGZip()
 	{
-		gzclose(file);
-	};
+		inflateEnd(&strm);
+	}
+
+
+	bool FileStreamGZip::fillInput()
+	{
+		// keep the unused input
+		if(strm.avail_in > 0 && strm.next_in != inBuffer.data())
+			std::memmove(inBuffer.data(), strm.next_in, strm.avail_in);
+
+		file.read(reinterpret_cast<char*>(inBuffer.data() + strm.avail_in), static_cast<std::streamsize>(inBuffer.size() - strm.avail_in));
+		const std::streamsize readBytes = file.gcount();
+
+		strm.next_in   = inBuffer.data();
+		strm.avail_in += static_cast<uInt>(readBytes);
+		inPos         += static_cast<std::uint64_t>(readBytes);
+
+		return readBytes > 0;
+	}
+
+	bool FileStreamGZip::restart(const GZipIndex::AccessPoint* point)
+	{
+		std::uint64_t fileStart = 0;
+		if(point)
+			fileStart = point->in - (point->bits ? 1 : 0);
+
+		file.clear();
+		file.seekg(static_cast<std::streamoff>(fileStart));
+		inPos         = fileStart;
+		strm.avail_in = 0;
+		strm.next_in  = inBuffer.data();
+		endOfData     = false;
+
+		if(!point)
+		{
+			rawDeflate = false;
+			outPos     = 0;
+			windowPos  = 0;
+			window.fill(0);
+			return inflateReset2(&strm, 15 + 16) == Z_OK;
+		}
+
+		rawDeflate = true;
+		outPos     = point->out;
+		if(inflateReset2(&strm, -15) != Z_OK)
+			return false;
+
+		if(point->bits)
+		{
+			if(!fillInput())
+				return false;
+			const int value = *strm.next_in;
+			++strm.next_in;
+			--strm.avail_in;
+			inflatePrime(&strm, point->bits, value >> (8 - point->bits));
+		}
+
+		std::copy(point->window.begin(), point->window.end(), window.begin());
+		windowPos = GZipIndex::windowSize;
+		return inflateSetDictionary(&strm, window.data(), static_cast<uInt>(GZipIndex::windowSize)) == Z_OK;
+	}
+
+	bool FileStreamGZip::nextMember()
+	{
+		// after an access point zlib doesn't know the gzip member, skip the trailer (crc32 and size)
+		if(rawDeflate)
+		{
+			for(int trailer = 8; trailer > 0; )
+			{
+				if(strm.avail_in == 0 && !fillInput())
+					return false;
+				const uInt skip = std::min(strm.avail_in, static_cast<uInt>(trailer));
+				strm.next_in  += skip;
+				strm.avail_in -= skip;
+				trailer       -= static_cast<int>(skip);
+			}
+		}
+
+		// concatenated gzip files, trailing garbage is ignored like gzread does
+		if(strm.avail_in < 2)
+			fillInput();
+		if(strm.avail_in < 2 || strm.next_in[0] != 0x1f || strm.next_in[1] != 0x8b)
+		{
+			endOfData = true;
+			index->setComplete(outPos);
+			return true;
+		}
+
+		rawDeflate = false;
+		return inflateReset2(&strm, 15 + 16) == Z_OK;
+	}
+
+	std::uint64_t FileStreamGZip::inflateData(char* dest, std::uint64_t size)
+	{
+		std::uint64_t inflated = 0;
+		while(inflated < size && !endOfData)
+		{
+			if(strm.avail_in == 0 && !fillInput())
+			{
+				BOOST_LOG_TRIVIAL(error) << "unexpected end of gzip data";
+				isGood = false;
+				break;
+			}
+
+			if(windowPos == GZipIndex::windowSize)
+				windowPos = 0;
+
+			// never inflate more than requested, so nothing has to be buffered between two reads
+			const uInt availOut = static_cast<uInt>(std::min<std::uint64_t>(GZipIndex::windowSize - windowPos, size - inflated));
+			strm.next_out  = window.data() + windowPos;
+			strm.avail_out = availOut;
+
+			const int ret = inflate(&strm, Z_BLOCK);
+
+			const uInt produced = availOut - strm.avail_out;
+			if(dest)
+				std::memcpy(dest + inflated, window.data() + windowPos, produced);
+			windowPos += produced;
+			inflated  += produced;
+			outPos    += produced;
+
+			if(ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR || ret == Z_STREAM_ERROR)
+			{
+				BOOST_LOG_TRIVIAL(error) << "inflate failed: " << (strm.msg ? strm.msg : "");
+				isGood = false;
+				break;
+			}
+
+			if(ret == Z_STREAM_END)
+			{
+				if(!nextMember())
+				{
+					BOOST_LOG_TRIVIAL(error) << "unexpected end of gzip data";
+					isGood = false;
+					break;
+				}
+				continue;
+			}
+
+			// at the end of a deflate block (but not the last one) the state is fully described by the window and the bit offset
+			if((strm.data_type & 128) && !(strm.data_type & 64) && index->needAccessPoint(outPos))
+				index->addAccessPoint(outPos, inPos - strm.avail_in, strm.data_type & 7, window.data(), windowPos);
+		}
+		return inflated;
+	}
+
+	bool FileStreamGZip::seekTo(std::uint64_t pos)
+	{
+		if(pos == outPos)
+			return true;
+
+		const GZipIndex::AccessPoint* point = index->findAccessPoint(pos);
+		if(pos < outPos || (point && point->out > outPos))
+		{
+			if(!restart(point))
+			{
+				BOOST_LOG_TRIVIAL(error) << "can't restart gzip stream";
+				return false;
+			}
+		}
+
+		const std::uint64_t skip = pos - outPos;
+		return inflateData(nullptr, skip) == skip;
+	}
+
+	std::streamsize FileStreamGZip::read(char* dest, std::streamsize size)
+	{
+		if(!isGood || size <= 0)
+			return 0;
+
+		if(!seekTo(readPos))
+		{
+			isGood = false;
+			return 0;
+		}
+
+		const std::uint64_t readBytes = inflateData(dest, static_cast<std::uint64_t>(size));
+		readPos += readBytes;
+		if(readBytes < static_cast<std::uint64_t>(size))
+			isGood = false;
+
+		return static_cast<std::streamsize>(readBytes);
+	}
 
 }
 
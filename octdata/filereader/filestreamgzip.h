@@ -22,22 +22,94 @@
 #include "filereader.h"
 #include <zlib.h>
 
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <vector>
+
 
 namespace OctData
 {
 
+	// zran-style random access index for gzip files:
+	// every span bytes of uncompressed data the inflate state (bit offset and 32K window) is stored,
+	// a seek restarts inflating at the nearest access point before the target.
+	// The index grows while the file is read and can be stored as sidecar file next to the gzip file.
+	class GZipIndex
+	{
+	public:
+		static const std::size_t windowSize  = 32768;
+		static const std::size_t defaultSpan = 1024*1024;
+
+		struct AccessPoint
+		{
+			std::uint64_t out  = 0;                                // position in the uncompressed data
+			std::uint64_t in   = 0;                                // position of the first complete byte in the compressed file
+			int           bits = 0;                                // number of bits of the byte before in (0 if none)
+			std::vector<unsigned char> window;                     // the last windowSize bytes of uncompressed data before out
+		};
+
+		explicit GZipIndex(std::size_t span = defaultSpan) : span(span) {}
+
+		std::size_t getSpan()                                    const { return span;          }
+		bool isComplete()                                        const { return complete;      }
+		bool isModified()                                        const { return modified;      }
+		std::size_t numAccessPoints()                            const { return points.size(); }
+		std::uint64_t uncompressedSize()                         const { return totalOut;      }
+
+		// last access point with point.out <= out, nullptr if there is none
+		const AccessPoint* findAccessPoint(std::uint64_t out) const;
+
+		bool needAccessPoint(std::uint64_t out)                  const { return !complete && (points.empty() || out >= points.back().out + span); }
+		void addAccessPoint(std::uint64_t out, std::uint64_t in, int bits, const unsigned char* window, std::size_t windowPos);
+		void setComplete(std::uint64_t totalOut);
+
+		static boost::filesystem::path indexFilepath(const boost::filesystem::path& gzipFile);
+
+		bool readIndexFile (const boost::filesystem::path& gzipFile);
+		bool writeIndexFile(const boost::filesystem::path& gzipFile);
+
+	private:
+		std::vector<AccessPoint> points;
+		std::size_t   span;
+		std::uint64_t totalOut = 0;
+		bool          complete = false;
+		bool          modified = false;
+	};
+
+
 	class FileStreamGZip : public FileStreamInterface
 	{
-		gzFile file;
+		std::ifstream file;
+		z_stream      strm;
+
+		std::shared_ptr<GZipIndex> index;
+
+		std::vector<unsigned char>                     inBuffer;
+		std::array<unsigned char, GZipIndex::windowSize> window;
+		std::size_t   windowPos = 0;
+
+		std::uint64_t inPos     = 0;                               // position in the compressed file after the buffered input
+		std::uint64_t outPos    = 0;                               // position of the inflate stream in the uncompressed data
+		std::uint64_t readPos   = 0;                               // position requested by seekg and read
+
+		bool rawDeflate = false;                                   // restarted at an access point (no gzip header and trailer handling by zlib)
+		bool endOfData  = false;
+		bool isGood     = true;
+
+		bool fillInput();
+		bool restart(const GZipIndex::AccessPoint* point);
+		bool seekTo(std::uint64_t pos);
+		bool nextMember();
+		std::uint64_t inflateData(char* dest, std::uint64_t size);
 	public:
-		FileStreamGZip(const boost::filesystem::path& filepath);
+		FileStreamGZip(const boost::filesystem::path& filepath, std::shared_ptr<GZipIndex> index = std::shared_ptr<GZipIndex>());
 		virtual ~FileStreamGZip();
 
-
-		virtual std::streamsize read(char* dest, std::streamsize size) override
-		                                                               { return gzread(file, dest, static_cast<unsigned>(size)); }
-		virtual void seekg(std::streamoff pos)                override { gzseek(file, pos, SEEK_SET); }
-		virtual bool good()                             const override { return !gzeof(file); }
+		virtual std::streamsize read(char* dest, std::streamsize size) override;
+		virtual void seekg(std::streamoff pos)                override { readPos = static_cast<std::uint64_t>(pos); }
+		virtual bool good()                             const override { return isGood; }
 	};
 
 }
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "filestreammmap.h"
+
+#include<cstring>
+
+namespace bip = boost::interprocess;
+
+namespace OctData
+{
+
+	FileStreamMMap::FileStreamMMap(const boost::filesystem::path& filepath)
+	: mapping(filepath.generic_string().c_str(), bip::read_only)
+	, region (mapping, bip::read_private) // copy on write, the mapped file is never changed
+	, data    (static_cast<const char*>(region.get_address()))
+	, dataSize(region.get_size())
+	{
+		// the readers walk through the file from the begin to the end
+		region.advise(bip::mapped_region::advice_sequential);
+		region.advise(bip::mapped_region::advice_willneed);
+	}
+
+	bool FileStreamMMap::checkRange(std::streamsize size)
+	{
+		if(size < 0 || pos > dataSize || static_cast<std::size_t>(size) > dataSize - pos)
+			isGood = false;
+		return isGood;
+	}
+
+	std::streamsize FileStreamMMap::read(char* dest, std::streamsize size)
+	{
+		if(!isGood)
+			return 0;
+
+		if(!checkRange(size))
+		{
+			// behave like std::istream: read the rest and set the fail state
+			if(pos < dataSize && size > 0)
+			{
+				const std::size_t rest = dataSize - pos;
+				std::memcpy(dest, data + pos, rest);
+				pos = dataSize;
+				return static_cast<std::streamsize>(rest);
+			}
+			return 0;
+		}
+
+		std::memcpy(dest, data + pos, static_cast<std::size_t>(size));
+		pos += static_cast<std::size_t>(size);
+		return size;
+	}
+
+	const char* FileStreamMMap::getMappedData(std::streamsize size)
+	{
+		if(!checkRange(size))
+			return nullptr;
+
+		const char* result = data + pos;
+		pos += static_cast<std::size_t>(size);
+		return result;
+	}
+}
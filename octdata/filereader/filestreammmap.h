@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include "filereader.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace OctData
+{
+
+	class FileStreamMMap : public FileStreamInterface
+	{
+		boost::interprocess::file_mapping  mapping;
+		boost::interprocess::mapped_region region;
+
+		const char* data     = nullptr;
+		std::size_t dataSize = 0;
+		std::size_t pos      = 0;
+		bool        isGood   = true;
+
+		bool checkRange(std::streamsize size);
+	public:
+		FileStreamMMap(const boost::filesystem::path& filepath);
+
+		virtual std::streamsize read(char* dest, std::streamsize size) override;
+		virtual void seekg(std::streamoff pos) override                { this->pos = static_cast<std::size_t>(pos); }
+
+		bool good()                                     const override { return isGood; }
+
+		virtual const char* getMappedData(std::streamsize size) override;
+		virtual bool isMemoryMapped()                   const override { return true; }
+	};
+
+}
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "filestreamuring.h"
+
+#ifdef WITH_IO_URING
+
+#include <algorithm>
+#include <cerrno>
+#include <exception>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <boost/log/trivial.hpp>
+
+
+namespace OctData
+{
+
+	FileStreamURing::FileStreamURing(const boost::filesystem::path& filepath)
+	{
+		fd = ::open(filepath.generic_string().c_str(), O_RDONLY | O_CLOEXEC);
+		if(fd < 0)
+			throw std::system_error(errno, std::generic_category(), "open " + filepath.generic_string());
+
+		const int ret = io_uring_queue_init(queueDepth, &ring, 0);
+		if(ret < 0)
+		{
+			::close(fd);
+			throw std::system_error(-ret, std::generic_category(), "io_uring_queue_init");
+		}
+	}
+
+	FileStreamURing::~FileStreamURing()
+	{
+		io_uring_queue_exit(&ring);
+		::close(fd);
+	}
+
+	std::size_t FileStreamURing::preadFull(char* dest, std::size_t size, std::size_t offset)
+	{
+		std::size_t done = 0;
+		while(done < size)
+		{
+			const ssize_t ret = ::pread(fd, dest + done, size - done, static_cast<off_t>(offset + done));
+			if(ret < 0 && errno == EINTR)
+				continue;
+			if(ret <= 0)
+				break;
+			done += static_cast<std::size_t>(ret);
+		}
+		return done;
+	}
+
+	std::streamsize FileStreamURing::read(char* dest, std::streamsize size)
+	{
+		if(!isGood || size <= 0)
+			return 0;
+
+		const std::size_t readBytes = preadFull(dest, static_cast<std::size_t>(size), pos);
+		pos += readBytes;
+		if(readBytes < static_cast<std::size_t>(size))
+			isGood = false;
+		return static_cast<std::streamsize>(readBytes);
+	}
+
+	bool FileStreamURing::waitCompletion(io_uring_cqe*& cqe)
+	{
+		for(;;)
+		{
+			const int ret = io_uring_wait_cqe(&ring, &cqe);
+			if(ret == 0)
+				return true;
+			if(ret != -EINTR && ret != -EAGAIN && ret != -EBUSY)
+			{
+				BOOST_LOG_TRIVIAL(error) << "io_uring_wait_cqe failed: " << std::system_category().message(-ret);
+				return false;
+			}
+		}
+	}
+
+	void FileStreamURing::cancelInFlight(const std::vector<bool>& inFlight, std::size_t numInFlight)
+	{
+		// the kernel writes into the buffers of the caller until the requests are completed or canceled
+		unsigned numCancel = 0;
+		for(std::size_t i = 0; i < inFlight.size(); ++i)
+		{
+			if(!inFlight[i])
+				continue;
+			io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+			if(!sqe)
+				break;
+			io_uring_prep_cancel(sqe, reinterpret_cast<void*>(i), 0);
+			io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(cancelUserData));
+			++numCancel;
+		}
+
+		const int submitted = io_uring_submit(&ring);
+		std::size_t numPending = numInFlight + (submitted > 0 ? static_cast<std::size_t>(submitted) : 0);
+		while(numPending > 0)
+		{
+			io_uring_cqe* cqe = nullptr;
+			if(!waitCompletion(cqe))
+			{
+				BOOST_LOG_TRIVIAL(fatal) << "io_uring requests can't be canceled, the read buffers are still in use";
+				std::terminate();
+			}
+			io_uring_cqe_seen(&ring, cqe);
+			--numPending;
+		}
+	}
+
+	std::size_t FileStreamURing::readBatch(const std::vector<ReadRequest>& requests)
+	{
+		std::vector<std::size_t> done(requests.size(), 0);
+		bool waitFailed = false;
+
+		// submit in chunks of queueDepth, incomplete requests (short reads, errors) are finished with pread
+		for(std::size_t chunkBegin = 0; chunkBegin < requests.size() && ringGood; chunkBegin += queueDepth)
+		{
+			const std::size_t chunkEnd = std::min(requests.size(), chunkBegin + queueDepth);
+
+			unsigned prepared = 0;
+			for(std::size_t i = chunkBegin; i < chunkEnd; ++i)
+			{
+				io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+				if(!sqe)
+					break;
+				io_uring_prep_read(sqe, fd, requests[i].dest, static_cast<unsigned>(requests[i].size), static_cast<__u64>(requests[i].offset));
+				io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(i));
+				++prepared;
+			}
+
+			const int submitted = io_uring_submit(&ring);
+			if(submitted < 0)
+			{
+				// the prepared entries are left in the ring, don't use the ring any more
+				BOOST_LOG_TRIVIAL(warning) << "io_uring_submit failed: " << std::system_category().message(-submitted) << ", use pread";
+				ringGood = false;
+				break;
+			}
+
+			// the entries are submitted in order, the first submitted ones are in flight
+			std::vector<bool> inFlight(requests.size(), false);
+			std::fill(inFlight.begin() + static_cast<std::ptrdiff_t>(chunkBegin), inFlight.begin() + static_cast<std::ptrdiff_t>(chunkBegin + static_cast<std::size_t>(submitted)), true);
+			std::size_t numInFlight = static_cast<std::size_t>(submitted);
+			while(numInFlight > 0)
+			{
+				io_uring_cqe* cqe = nullptr;
+				if(!waitCompletion(cqe))
+				{
+					// wait for the requests in flight before the buffers are returned to the caller
+					cancelInFlight(inFlight, numInFlight);
+					ringGood   = false;
+					waitFailed = true;
+					break;
+				}
+
+				const std::size_t index = reinterpret_cast<std::size_t>(io_uring_cqe_get_data(cqe));
+				if(index < done.size() && inFlight[index])
+				{
+					if(cqe->res > 0)
+						done[index] = static_cast<std::size_t>(cqe->res);
+					inFlight[index] = false;
+					--numInFlight;
+				}
+				io_uring_cqe_seen(&ring, cqe);
+			}
+			if(waitFailed)
+				break;
+
+			if(static_cast<unsigned>(submitted) < prepared)
+				ringGood = false;
+		}
+
+		// all requests are completed or canceled, the partially read data is not reliable
+		if(waitFailed)
+		{
+			isGood = false;
+			return 0;
+		}
+
+		std::size_t numRead = 0;
+		for(std::size_t i = 0; i < requests.size(); ++i)
+		{
+			const ReadRequest& request = requests[i];
+			const std::size_t size = static_cast<std::size_t>(request.size);
+			if(done[i] < size)
+				done[i] += preadFull(request.dest + done[i], size - done[i], static_cast<std::size_t>(request.offset) + done[i]);
+
+			if(done[i] < size)
+			{
+				isGood = false;
+				break;
+			}
+			++numRead;
+		}
+		return numRead;
+	}
+
+}
+
+#endif
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2018 Kay Gawlik <kaydev@amarunet.de> <kay.gawlik@beuth-hochschule.de> <kay.gawlik@charite.de>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifdef WITH_IO_URING
+
+#include "filereader.h"
+
+#include <liburing.h>
+
+
+namespace OctData
+{
+
+	// file stream for linux io_uring: single reads are done with pread,
+	// readBatch submits the requests together (up to queueDepth in flight), which hides the latency of network file systems
+	class FileStreamURing : public FileStreamInterface
+	{
+		static const unsigned    queueDepth     = 64;
+		static const std::size_t cancelUserData = ~static_cast<std::size_t>(0);
+
+		int         fd       = -1;
+		io_uring    ring;
+		bool        ringGood = true;
+		std::size_t pos      = 0;
+		bool        isGood   = true;
+
+		std::size_t preadFull(char* dest, std::size_t size, std::size_t offset);
+		bool waitCompletion(io_uring_cqe*& cqe);
+		void cancelInFlight(const std::vector<bool>& inFlight, std::size_t numInFlight);
+	public:
+		// throws std::system_error if the file can't be opened or io_uring is not available
+		explicit FileStreamURing(const boost::filesystem::path& filepath);
+		virtual ~FileStreamURing();
+
+		FileStreamURing(const FileStreamURing&)            = delete;
+		FileStreamURing& operator=(const FileStreamURing&) = delete;
+
+		virtual std::streamsize read(char* dest, std::streamsize size) override;
+		virtual void seekg(std::streamoff pos) override                { this->pos = static_cast<std::size_t>(pos); }
+
+		bool good()                                     const override { return isGood; }
+
+		virtual std::size_t readBatch(const std::vector<ReadRequest>& requests) override;
+	};
+
+}
+
+#endif
@@ -39,4 +39,51 @@ namespace OctData
 		else if(*this == "u16"  ) obj = FileReadOptions::E2eGrayTransform::u16;
 		else obj = FileReadOptions::E2eGrayTransform::xml;
 	}
+
+	template<> void FileReadOptions::SegmentationStorageEnumWrapper::toString()
+	{
+		switch(obj)
+		{
+			case FileReadOptions::SegmentationStorage::bscan  : std::string::operator=("bscan"  ); break;
+			case FileReadOptions::SegmentationStorage::float32: std::string::operator=("float32"); break;
+			case FileReadOptions::SegmentationStorage::int16  : std::string::operator=("int16"  ); break;
+		}
+	}
+
+	template<> void FileReadOptions::SegmentationStorageEnumWrapper::fromString()
+	{
+		     if(*this == "float32") obj = FileReadOptions::SegmentationStorage::float32;
+		else if(*this == "int16"  ) obj = FileReadOptions::SegmentationStorage::int16;
+		else obj = FileReadOptions::SegmentationStorage::bscan;
+	}
+
+	template<> void FileReadOptions::MemoryBudgetActionEnumWrapper::toString()
+	{
+		switch(obj)
+		{
+			case FileReadOptions::MemoryBudgetAction::fail: std::string::operator=("fail"); break;
+			case FileReadOptions::MemoryBudgetAction::lazy: std::string::operator=("lazy"); break;
+		}
+	}
+
+	template<> void FileReadOptions::MemoryBudgetActionEnumWrapper::fromString()
+	{
+		     if(*this == "fail") obj = FileReadOptions::MemoryBudgetAction::fail;
+		else obj = FileReadOptions::MemoryBudgetAction::lazy;
+	}
+
+	template<> void FileReadOptions::RawStorageEnumWrapper::toString()
+	{
+		switch(obj)
+		{
+			case FileReadOptions::RawStorage::native : std::string::operator=("native" ); break;
+			case FileReadOptions::RawStorage::float16: std::string::operator=("float16"); break;
+		}
+	}
+
+	template<> void FileReadOptions::RawStorageEnumWrapper::fromString()
+	{
+		     if(*this == "float16") obj = FileReadOptions::RawStorage::float16;
+		else obj = FileReadOptions::RawStorage::native;
+	}
 }
@@ -26,19 +26,37 @@ namespace OctData
 	{
 	public:
 		enum class E2eGrayTransform { nativ, xml, vol, u16 };
+		enum class SegmentationStorage { bscan, float32, int16 };
+		enum class MemoryBudgetAction { fail, lazy };
+		enum class RawStorage { native, float16 };
 		typedef ObjectWrapper<E2eGrayTransform> E2eGrayTransformEnumWrapper;
+		typedef ObjectWrapper<SegmentationStorage> SegmentationStorageEnumWrapper;
+		typedef ObjectWrapper<MemoryBudgetAction> MemoryBudgetActionEnumWrapper;
+		typedef ObjectWrapper<RawStorage> RawStorageEnumWrapper;
 
 		bool fillEmptyPixelWhite = true;
 		bool registerBScanns     = true;
 		bool rotateSlo           = false;
 
 		bool holdRawData         = false;
+		RawStorage rawStorage    = RawStorage::native;             // float16: float raw images (vol) as IEEE half, BScan::getRawImageFloat decodes them
 		bool loadRefFiles        = true;
 		bool readBScans          = true;
+		bool lazyBScans          = false;                          // decode B-scan images on first access (vol, cirrus img, gipl, Bioptigen oct), not combined with holdRawData
+		int  lazyCacheSizeMB     = 256;                            // memory limit for the decoded images of lazy B-scans and the derived images
+		bool deriveBScanImages   = false;                          // E2E, vol: hold only the raw images, the 8 bit images are derived on access (Series::changeDerivedImageSettings)
+		int  numThreads          = 0;                              // threads for decoding B-scans, <= 0: one per hardware thread
+		int  memoryBudgetMB      = 0;                              // memory limit for the loaded file (OCT::memoryUsage), 0: no limit
+		MemoryBudgetAction memoryBudgetAction = MemoryBudgetAction::lazy; // estimate over the budget or unknown: fail or read with lazyBScans (fails for readers without lazy B-scans; unknown: read, checked after reading)
+		bool packBScans          = false;                          // store the B-scan images of a series in one contiguous buffer (Series::packBScanImages), not combined with lazyBScans
 
 		bool dumpFileParts       = false;
 
+		bool gzipIndexFile       = false;                          // store the random access index of gzip files as sidecar file (<file>.gzidx)
+		bool ioUring             = false;                          // read uncompressed files with io_uring batches instead of memory mapping (only with BUILD_WITH_IO_URING)
+
 		E2eGrayTransform e2eGray = E2eGrayTransform::xml;
+		SegmentationStorage segmentationStorage = SegmentationStorage::bscan; // float32, int16: one SegmentationStore per series (Series::packSegmentation)
 
 		std::string libPath;
 
@@ -50,14 +68,28 @@ namespace OctData
 		static void getSetParameter(T& getSet, ParameterSet& p)
 		{
 			E2eGrayTransformEnumWrapper e2eGrayWrapper(p.e2eGray);
+			SegmentationStorageEnumWrapper segStorageWrapper(p.segmentationStorage);
+			MemoryBudgetActionEnumWrapper  budgetActionWrapper(p.memoryBudgetAction);
+			RawStorageEnumWrapper          rawStorageWrapper(p.rawStorage);
 
 			getSet("fillEmptyPixelWhite", p.fillEmptyPixelWhite                    );
 			getSet("registerBScanns"    , p.registerBScanns                        );
 			getSet("rotateSlo"          , p.rotateSlo                              );
 			getSet("holdRawData"        , p.holdRawData                            );
+			getSet("rawStorage"         , static_cast<std::string&>(rawStorageWrapper));
 			getSet("loadRefFiles"       , p.loadRefFiles                           );
 			getSet("readBScans"         , p.readBScans                             );
+			getSet("lazyBScans"         , p.lazyBScans                             );
+			getSet("lazyCacheSizeMB"    , p.lazyCacheSizeMB                        );
+			getSet("deriveBScanImages"  , p.deriveBScanImages                      );
+			getSet("numThreads"         , p.numThreads                             );
+			getSet("memoryBudgetMB"     , p.memoryBudgetMB                         );
+			getSet("memoryBudgetAction" , static_cast<std::string&>(budgetActionWrapper));
+			getSet("packBScans"         , p.packBScans                             );
+			getSet("gzipIndexFile"      , p.gzipIndexFile                          );
+			getSet("ioUring"            , p.ioUring                                );
 			getSet("e2eGrayTransform"   , static_cast<std::string&>(e2eGrayWrapper));
+			getSet("segmentationStorage", static_cast<std::string&>(segStorageWrapper));
 		}
 	};
 }
@@ -18,6 +18,8 @@
 #include <oct_cpp_framework/callback.h>
 
 #include<filereader/filereader.h>
+#include<fileprobe.h>
+#include"../lazybscanloader.h"
 
 #include <boost/log/trivial.hpp>
 
@@ -26,6 +28,8 @@ namespace bfs = boost::filesystem;
 
 namespace
 {
+	const std::size_t maxBatchBytes = 64*1024*1024;
+
 	template<typename T>
 	void readCVImage(std::istream& stream, cv::Mat& image, std::size_t sizeX, std::size_t sizeY)
 	{
@@ -33,44 +37,28 @@ namespace
 		std::size_t num = sizeX*sizeY;
 		stream.read(reinterpret_cast<char*>(image.data), num*sizeof(T));
 	}
-}
 
-
-namespace OctData
-{
-	CirrusRawRead::CirrusRawRead()
-	: OctFileReader(OctExtension{".img", ".img.gz", "Cirrus img files"})
+	void readBScanImage(OctData::FileReader& filereader, cv::Mat& bscanImage, std::size_t volSizeX, std::size_t volSizeZ)
 	{
-
+		cv::Mat bscanImageFile; // view into the file, only valid while the file is open
+		filereader.readCVImageView<uint8_t>(bscanImageFile, volSizeZ, volSizeX);
+		cv::flip(bscanImageFile, bscanImage, -1);
 	}
 
-	bool CirrusRawRead::readFile(FileReader& filereader, OCT& oct, const FileReadOptions& /*op*/, CppFW::Callback* callback)
+	struct CirrusFileInfo
+	{
+		std::string patientId;
+		std::string eyeSide;
+		std::size_t volSizeX = 0;
+		std::size_t volSizeY = 0;
+	};
+
+	// the metadata of cirrus img files is coded in the filename
+	bool parseFilename(const bfs::path& file, CirrusFileInfo& info, bool debug)
 	{
-		const boost::filesystem::path& file = filereader.getFilepath();
-
-		if(filereader.getExtension() != ".img")
-			return false;
-
-		BOOST_LOG_TRIVIAL(trace) << "Try to open OCT file as cirrus img";
-
-		if(!filereader.openFile())
-		{
-			BOOST_LOG_TRIVIAL(error) << "Can't open cirrus img file " << filereader.getFilepath().generic_string();
-			return false;
-		}
-		/*
-		if(file.extension() != ".img")
-			return false;
-
-		if(!bfs::exists(file))
-			return false;
-		*/
-
-		bool debug = false;
-
 		// split filename in elements
 		std::vector<std::string> elements;
-		std::string filenameString = filereader.getFilepath().filename().generic_string();
+		std::string filenameString = file.filename().generic_string();
 		boost::split(elements, filenameString, boost::is_any_of("_"), boost::token_compress_on);
 
 		if(debug)
@@ -105,6 +93,9 @@ namespace OctData
 			std::cout << "filetype  : " << filetype   << std::endl;
 		}
 
+		info.patientId = patient_id;
+		info.eyeSide   = eye_side;
+
 		if(filetype.substr(0, 7) != "raw.img" && filetype.substr(0, 5) != "z.img")
 		{
 			BOOST_LOG_TRIVIAL(error) << "wring filetype (not raw.img or z.img): " << filetype.substr(0, 7);
@@ -133,8 +124,103 @@ namespace OctData
 			return false;
 		}
 
-		std::size_t volSizeX = boost::lexical_cast<std::size_t>(scanSizeElements[0]);
-		std::size_t volSizeY = boost::lexical_cast<std::size_t>(scanSizeElements[1]);
+		info.volSizeX = boost::lexical_cast<std::size_t>(scanSizeElements[0]);
+		info.volSizeY = boost::lexical_cast<std::size_t>(scanSizeElements[1]);
+
+		return true;
+	}
+
+	bfs::path getSloFilepath(const bfs::path& file)
+	{
+		std::string fileString = file.generic_string();
+		std::size_t found = fileString.find_last_of("_");
+		found = fileString.find_last_of("_", found-1);
+		std::string baseFilename = fileString.substr(0, found);
+
+		return bfs::path(baseFilename + "_lslo.bin");
+	}
+}
+
+
+namespace OctData
+{
+	CirrusRawRead::CirrusRawRead()
+	: OctFileReader(OctExtension{".img", ".img.gz", "Cirrus img files"})
+	{
+
+	}
+
+	bool CirrusRawRead::probeFile(FileReader& filereader, FileProbe& probe)
+	{
+		const boost::filesystem::path& file = filereader.getFilepath();
+
+		if(filereader.getExtension() != ".img")
+			return false;
+
+		CirrusFileInfo fileInfo;
+		if(!parseFilename(file, fileInfo, false))
+			return false;
+
+		if(!filereader.openFile(true))
+		{
+			BOOST_LOG_TRIVIAL(error) << "Can't open cirrus img file " << file.generic_string();
+			return false;
+		}
+
+		probe.series.emplace_back();
+		FileProbe::SeriesInfo& info = probe.series.back();
+		info.patientId   = fileInfo.patientId;
+		info.bscanCount  = fileInfo.volSizeY;
+		info.bscanWidth  = fileInfo.volSizeX;
+		info.bscanHeight = filereader.file_size() / fileInfo.volSizeX / fileInfo.volSizeY;
+
+		if(fileInfo.eyeSide == "OD")
+			info.laterality = Series::Laterality::OD;
+		else if(fileInfo.eyeSide == "OS")
+			info.laterality = Series::Laterality::OS;
+
+		const bfs::path slofile = getSloFilepath(file);
+		boost::system::error_code ec;
+		const boost::uintmax_t filesizeSlo = bfs::file_size(slofile, ec);
+		if(!ec)
+		{
+			const std::size_t sloWidth = 512;
+			info.sloWidth  = sloWidth;
+			info.sloHeight = static_cast<std::size_t>(filesizeSlo)/sloWidth;
+		}
+		return true;
+	}
+
+	bool CirrusRawRead::readFile(FileReader& filereader, OCT& oct, const FileReadOptions& op, CppFW::Callback* callback)
+	{
+		const boost::filesystem::path& file = filereader.getFilepath();
+
+		if(filereader.getExtension() != ".img")
+			return false;
+
+		BOOST_LOG_TRIVIAL(trace) << "Try to open OCT file as cirrus img";
+
+		if(!filereader.openFile(true))
+		{
+			BOOST_LOG_TRIVIAL(error) << "Can't open cirrus img file " << filereader.getFilepath().generic_string();
+			return false;
+		}
+		/*
+		if(file.extension() != ".img")
+			return false;
+
+		if(!bfs::exists(file))
+			return false;
+		*/
+
+		bool debug = false;
+
+		CirrusFileInfo fileInfo;
+		if(!parseFilename(file, fileInfo, debug))
+			return false;
+
+		const std::size_t volSizeX = fileInfo.volSizeX;
+		const std::size_t volSizeY = fileInfo.volSizeY;
 
 		if(debug)
 			std::cout << "vol_size " << volSizeX << " : " << volSizeY << std::endl;
@@ -174,6 +260,20 @@ end
 
 		std::vector<BScan*> bscanList;
 
+		std::unique_ptr<LazyBScanLoader> lazyLoader;
+		if(LazyBScanLoader::useLazyLoading(op))
+		{
+			lazyLoader.reset(new LazyBScanLoader(filereader, op));
+			if(!lazyLoader->isOpen())
+				lazyLoader.reset();
+		}
+
+		const std::size_t bscanSize   = volSizeX*volSizeZ;
+		const std::size_t batchBScans = std::max<std::size_t>(1, maxBatchBytes/std::max<std::size_t>(1, bscanSize));
+		std::vector<cv::Mat> batchImages;
+		std::size_t batchBegin = 0;
+		std::size_t batchRead  = 0;
+
 		BScan::Data data;
 		data.scaleFactor = sf;
 		for(std::size_t i = 0; i<volSizeY; ++i)
@@ -184,10 +284,38 @@ end
 					break;
 			}
 
+			if(lazyLoader)
+			{
+				const std::size_t bscanPos = i*volSizeX*volSizeZ;
+				auto decode = [bscanPos, volSizeX, volSizeZ](FileReader& reader, cv::Mat& image)
+				{
+					reader.seekg(bscanPos);
+					readBScanImage(reader, image, volSizeX, volSizeZ);
+					return reader.good();
+				};
+				bscanList.push_back(lazyLoader->createBScan(decode, static_cast<int>(volSizeX), static_cast<int>(volSizeZ), data));
+				continue;
+			}
+
 			cv::Mat bscanImage;
-// 			readCVImage<uint8_t>(stream, bscanImage, volSizeZ, volSizeX);
-			filereader.readCVImage<uint8_t>(bscanImage, volSizeZ, volSizeX);
-			cv::flip(bscanImage, bscanImage, -1);
+			if(filereader.isMemoryMapped())
+			{
+// 				readCVImage<uint8_t>(stream, bscanImage, volSizeZ, volSizeX);
+				readBScanImage(filereader, bscanImage, volSizeX, volSizeZ);
+			}
+			else
+			{
+				// read the B-scans in batches (one submit with io_uring)
+				if(i >= batchBegin + batchImages.size())
+				{
+					batchBegin = i;
+					const std::size_t num = std::min(batchBScans, volSizeY - i);
+					batchRead = filereader.readCVImageBatch<uint8_t>(batchImages, static_cast<std::streamoff>(i*bscanSize), static_cast<std::streamoff>(bscanSize), num, volSizeZ, volSizeX);
+				}
+				if(i - batchBegin >= batchRead)
+					break;
+				cv::flip(batchImages[i - batchBegin], bscanImage, -1);
+			}
 
 			bscanList.push_back(new BScan(bscanImage, data));
 		}
@@ -198,12 +326,7 @@ end
 		//------------
 		// load slo
 		//------------
-		std::string fileString = file.generic_string();
-		std::size_t found = fileString.find_last_of("_");
-		found = fileString.find_last_of("_", found-1);
-		std::string baseFilename = fileString.substr(0, found);
-
-		bfs::path slofile(baseFilename + "_lslo.bin");
+		bfs::path slofile = getSloFilepath(file);
 		std::cout << slofile.generic_string() << std::endl;
 		if(!bfs::exists(slofile))
 			return true; // bscans loaded successfull
@@ -116,6 +116,7 @@ namespace OctData
 	DicomRead::DicomRead()
 	: OctFileReader({OctExtension{".dicom", ".dcm", "Dicom File"}, OctExtension("DICOMDIR", "DICOM DIR")})
 	{
+		addSignature(128, "DICM");
 	}
 
 
@@ -371,14 +372,6 @@ namespace OctData
 	{
 		const std::string filename = filereader.getFilepath().generic_string();
 
-
-
-		std::string ext = filereader.getFilepath().extension().generic_string();
-		std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-		if(ext != ".dicom"
-		&& ext != ".dcm")
-			return false;
-
 		BOOST_LOG_TRIVIAL(info) << "ReadDICOM: " << filename;
 
 		/* Load file and get pixel data element */
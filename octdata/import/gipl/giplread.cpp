@@ -1,6 +1,9 @@
 #include "giplread.h"
 
+#include<algorithm>
+
 #include<boost/endian/arithmetic.hpp>
+#include<boost/endian/conversion.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/log/trivial.hpp>
 
@@ -21,6 +24,8 @@ namespace bfs = boost::filesystem;
 
 
 #include<filereader/filereader.h>
+#include<fileprobe.h>
+#include"../lazybscanloader.h"
 
 
 // GIPL magic number
@@ -51,6 +56,8 @@ namespace OctData
 
 	namespace
 	{
+		const std::size_t maxBatchBytes = 64*1024*1024;
+
 		template<typename T>
 		void readFStream(std::istream& stream, T* dest, std::size_t num = 1)
 		{
@@ -122,21 +129,40 @@ namespace OctData
 
 	struct ReadUInt8
 	{
+		typedef uint8_t PixelType;
+
+		static void scanImages(FileReader& /*filereader*/, std::size_t /*sizeX*/, std::size_t /*sizeY*/, std::size_t /*numBScans*/) {}
 		static void readImg(FileReader& filereader, cv::Mat& image, std::size_t sizeX, std::size_t sizeY) { filereader.readCVImage<uint8_t>(image, sizeY, sizeX); }
+		static void processImg(const cv::Mat& imageFile, cv::Mat& image) { image = imageFile; }
 		static void convertImage(cv::Mat& /*image*/) {}
 	};
 	struct ReadUInt16
 	{
+		typedef uint16_t PixelType;
+
 		double maxVal = 1;
 
+		// the conversion to uint8 needs the maximum of all B-scans
+		void scanImages(FileReader& filereader, std::size_t sizeX, std::size_t sizeY, std::size_t numBScans)
+		{
+			cv::Mat image;
+			for(std::size_t numBscan = 0; numBscan<numBScans; ++numBscan)
+				readImg(filereader, image, sizeX, sizeY);
+		}
+
 		void readImg(FileReader& filereader, cv::Mat& image, std::size_t sizeX, std::size_t sizeY)
 		{
-			filereader.readCVImage<uint16_t>(image, sizeY, sizeX);
-			auto imgIt    = image.begin<uint16_t>();
-			auto imgItEnd = image.end  <uint16_t>();
+			cv::Mat imageFile; // view into the file, only valid while the file is open
+			filereader.readCVImageView<uint16_t>(imageFile, sizeY, sizeX);
+			processImg(imageFile, image);
+		}
 
-			for(;imgIt != imgItEnd; ++imgIt)
-				boost::endian::big_to_native_inplace(*imgIt);
+		void processImg(const cv::Mat& imageFile, cv::Mat& image)
+		{
+			image.create(imageFile.rows, imageFile.cols, imageFile.type());
+
+			std::transform(imageFile.begin<uint16_t>(), imageFile.end<uint16_t>(), image.begin<uint16_t>()
+			            , [](uint16_t value) { return boost::endian::big_to_native(value); });
 
 			double min, max;
 			cv::minMaxLoc(image, &min, &max);
@@ -158,19 +184,74 @@ namespace OctData
 		const std::size_t sizeY     = giplHeader.getSizeY();
 		const std::size_t numBScans = giplHeader.getSizeZ();
 
+		if(LazyBScanLoader::useLazyLoading(op))
+		{
+			LazyBScanLoader lazyLoader(filereader, op);
+			if(lazyLoader.isOpen())
+			{
+				reader.scanImages(filereader, sizeX, sizeY, numBScans);
+
+				const std::size_t bscanSize = sizeX*sizeY*sizeof(typename T::PixelType);
+				for(std::size_t numBscan = 0; numBscan<numBScans; ++numBscan)
+				{
+					const std::size_t bscanPos = GIPL_HEADERSIZE + numBscan*bscanSize;
+					auto decode = [bscanPos, sizeX, sizeY, reader](FileReader& file, cv::Mat& image) mutable
+					{
+						file.seekg(bscanPos);
+						reader.readImg(file, image, sizeX, sizeY);
+						reader.convertImage(image);
+						return file.good();
+					};
+
+					BScan::Data bscanData;
+					series.takeBScan(lazyLoader.createBScan(decode, static_cast<int>(sizeX), static_cast<int>(sizeY), bscanData));
+				}
+				return;
+			}
+		}
+
 		std::vector<cv::Mat> bscanTemp;
 		bscanTemp.reserve(numBScans);
 
-		for(std::size_t numBscan = 0; numBscan<numBScans; ++numBscan)
+		if(!filereader.isMemoryMapped())
+		{
+			// without a mapping the B-scans are fetched in batches of known offsets
+			const std::size_t bscanSize = sizeX*sizeY*sizeof(typename T::PixelType);
+			const std::size_t batchSize = std::max(static_cast<std::size_t>(1), maxBatchBytes/bscanSize);
+			std::vector<cv::Mat> batchImages;
+			for(std::size_t numBscan = 0; numBscan<numBScans; numBscan += batchSize)
+			{
+				if(callback)
+					callback->callback(static_cast<double>(numBscan)/static_cast<double>(numBScans));
+
+				const std::size_t num  = std::min(batchSize, numBScans - numBscan);
+				const std::size_t read = filereader.readCVImageBatch<typename T::PixelType>(batchImages
+				                                                                          , static_cast<std::streamoff>(GIPL_HEADERSIZE + numBscan*bscanSize)
+				                                                                          , static_cast<std::streamoff>(bscanSize)
+				                                                                          , num, sizeY, sizeX);
+				for(std::size_t i = 0; i < read; ++i)
+				{
+					cv::Mat bscanImage;
+					reader.processImg(batchImages[i], bscanImage);
+					bscanTemp.push_back(bscanImage);
+				}
+				if(read < num)
+					break;
+			}
+		}
+		else
 		{
-			if(callback)
-				callback->callback(static_cast<double>(numBscan)/static_cast<double>(numBScans));
+			for(std::size_t numBscan = 0; numBscan<numBScans; ++numBscan)
+			{
+				if(callback)
+					callback->callback(static_cast<double>(numBscan)/static_cast<double>(numBScans));
 
-			cv::Mat bscanImage;
-			reader.readImg(filereader, bscanImage, sizeX, sizeY);
-// 			filereader.readCVImage<uint8_t>(bscanImage, sizeY, sizeX);
+				cv::Mat bscanImage;
+				reader.readImg(filereader, bscanImage, sizeX, sizeY);
+// 				filereader.readCVImage<uint8_t>(bscanImage, sizeY, sizeX);
 
-			bscanTemp.push_back(bscanImage);
+				bscanTemp.push_back(bscanImage);
+			}
 		}
 
 		for(cv::Mat& bscanImage : bscanTemp)
@@ -185,16 +266,14 @@ namespace OctData
 		}
 	}
 
-	bool GIPLRead::readFile(FileReader& filereader, OctData::OCT& oct, const OctData::FileReadOptions& op, CppFW::Callback* callback)
+	// checks the file format and reads the header
+	bool readGiplHeader(FileReader& filereader, GIPLRead::GiplHeader& giplHeader)
 	{
-		if(filereader.getExtension() != ".gipl")
-			return false;
-
 		const std::string filename = filereader.getFilepath().generic_string();
 		BOOST_LOG_TRIVIAL(trace) << "Try to open OCT file as gpil";
 
 
-		if(!filereader.openFile())
+		if(!filereader.openFile(true))
 		{
 			BOOST_LOG_TRIVIAL(error) << "Can't open vol file " << filename;
 			return false;
@@ -203,9 +282,7 @@ namespace OctData
 		BOOST_LOG_TRIVIAL(debug) << "open " << filename << " as gpil file";
 
 
-		GiplHeader giplHeader;
 		giplHeader.readInfo(filereader);
-		giplHeader.print(std::cout);
 		if(!giplHeader.numberCheck())
 		{
 			BOOST_LOG_TRIVIAL(error) << "Can't open vol file " << filename;
@@ -220,6 +297,30 @@ namespace OctData
 			return false;
 		}
 
+		return true;
+	}
+
+	bool GIPLRead::probeFile(FileReader& filereader, FileProbe& probe)
+	{
+		GiplHeader giplHeader;
+		if(!readGiplHeader(filereader, giplHeader))
+			return false;
+
+		probe.series.emplace_back();
+		FileProbe::SeriesInfo& info = probe.series.back();
+		info.bscanCount  = giplHeader.getSizeZ();
+		info.bscanWidth  = giplHeader.getSizeX();
+		info.bscanHeight = giplHeader.getSizeY();
+		return true;
+	}
+
+	bool GIPLRead::readFile(FileReader& filereader, OctData::OCT& oct, const OctData::FileReadOptions& op, CppFW::Callback* callback)
+	{
+		GiplHeader giplHeader;
+		if(!readGiplHeader(filereader, giplHeader))
+			return false;
+
+		giplHeader.print(std::cout);
 		filereader.seekg(GIPL_HEADERSIZE);
 
 
@@ -240,6 +341,7 @@ namespace OctData
 	GIPLRead::GIPLRead()
 	: OctFileReader(OctExtension{".gipl", ".gipl.gz", "Guys Image Processing Lab Format"})
 	{
+		addSignature(252, std::string("\xef\xff\xe9\xb0", 4)); // magic number (big endian)
 	}
 
 
@@ -0,0 +1,222 @@
+#include "he_e2eprobe.h"
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <boost/endian/arithmetic.hpp>
+#include <boost/log/trivial.hpp>
+
+#include <fileprobe.h>
+#include <filereader/filereader.h>
+
+namespace OctData
+{
+	namespace
+	{
+		typedef boost::endian::little_uint16_t le_uint16;
+		typedef boost::endian::little_uint32_t le_uint32;
+		typedef boost::endian::little_int32_t  le_int32;
+
+		const char fileMagic[] = "CMDb";
+
+		const std::uint32_t chunkTypePatientData = 9;
+		const std::uint32_t chunkTypeImage       = 0x40000000;
+
+		const std::uint16_t imageIndSlo   = 0;
+		const std::uint16_t imageIndBScan = 1;
+
+		const std::size_t patientIdOffset = 102; // forename[31], surname[66], birthdate, sex
+		const std::size_t patientIdSize   = 25;
+
+		struct BlockHeader
+		{
+			char      magic[12];
+			le_uint32 version;
+			le_uint16 unknown[10];
+		};
+
+		struct DirectoryHeader
+		{
+			BlockHeader header;
+			le_uint32   numEntries;
+			le_uint32   current;
+			le_uint32   prev;
+			le_uint32   unknown;
+		};
+
+		struct DirectoryEntry
+		{
+			le_uint32 pos;
+			le_uint32 start;
+			le_uint32 size;
+			le_uint32 unknown0;
+			le_uint32 patientId;
+			le_uint32 studyId;
+			le_uint32 seriesId;
+			le_int32  sliceId;
+			le_uint16 ind;
+			le_uint16 unknown1;
+			le_uint32 type;
+			le_uint32 unknown2;
+		};
+
+		struct ChunkHeader
+		{
+			char      magic[12];
+			le_uint32 unknown0;
+			le_uint32 unknown1;
+			le_uint32 pos;
+			le_uint32 size;
+			le_uint32 unknown2;
+			le_uint32 patientId;
+			le_uint32 studyId;
+			le_uint32 seriesId;
+			le_int32  sliceId;
+			le_uint16 ind;
+			le_uint16 unknown3;
+			le_uint32 type;
+			le_uint32 unknown4;
+		};
+
+		struct ImageHeader
+		{
+			le_uint32 size;
+			le_uint32 type;
+			le_uint32 numValues;
+			le_uint32 height;
+			le_uint32 width;
+		};
+
+		typedef std::tuple<std::uint32_t, std::uint32_t, std::uint32_t> SeriesKey; // patient, study, series
+
+		struct SeriesSummary
+		{
+			std::set<std::int32_t> bscanSlices;
+			std::size_t            bscanWidth  = 0;
+			std::size_t            bscanHeight = 0;
+			std::size_t            sloWidth    = 0;
+			std::size_t            sloHeight   = 0;
+		};
+
+		template<typename T>
+		bool readAt(FileReader& filereader, std::size_t pos, T& dest)
+		{
+			if(pos + sizeof(T) > filereader.file_size())
+				return false;
+			filereader.seekg(static_cast<std::streamoff>(pos));
+			filereader.readFStream(&dest);
+			return filereader.good();
+		}
+
+		bool readImageHeader(FileReader& filereader, const DirectoryEntry& entry, std::size_t& width, std::size_t& height)
+		{
+			ImageHeader image;
+			if(entry.size < sizeof(ChunkHeader) + sizeof(ImageHeader) || !readAt(filereader, entry.start + sizeof(ChunkHeader), image))
+				return false;
+			width  = image.width;
+			height = image.height;
+			return true;
+		}
+
+		std::string readPatientId(FileReader& filereader, const DirectoryEntry& entry)
+		{
+			char id[patientIdSize];
+			if(entry.size < sizeof(ChunkHeader) + patientIdOffset + patientIdSize || !readAt(filereader, entry.start + sizeof(ChunkHeader) + patientIdOffset, id))
+				return std::string();
+			return std::string(id, strnlen(id, patientIdSize));
+		}
+	}
+
+
+	bool probeHeE2EFile(FileReader& filereader, FileProbe& probe)
+	{
+		const std::string filename = filereader.getFilepath().generic_string();
+		if(!filereader.openFile())
+			return false;
+
+		BlockHeader     fileHeader;
+		DirectoryHeader mainDirectory;
+		if(!readAt(filereader, 0, fileHeader)
+		|| std::memcmp(fileHeader.magic, fileMagic, sizeof(fileMagic) - 1) != 0
+		|| !readAt(filereader, sizeof(BlockHeader), mainDirectory))
+			return false;
+
+		std::map<SeriesKey, SeriesSummary>  seriesSummaries;
+		std::map<std::uint32_t, std::string> patientIds;
+
+		// the directory blocks are a list from the last block back to the first one
+		const std::size_t fileSize = filereader.file_size();
+		std::set<std::uint32_t> visitedDirectories;
+		for(std::uint32_t dirPos = mainDirectory.current; dirPos != 0; )
+		{
+			if(!visitedDirectories.insert(dirPos).second)
+			{
+				BOOST_LOG_TRIVIAL(warning) << filename << ": cyclic E2E directory list";
+				break;
+			}
+
+			DirectoryHeader directory;
+			if(!readAt(filereader, dirPos, directory)
+			|| directory.numEntries > (fileSize - dirPos - sizeof(DirectoryHeader))/sizeof(DirectoryEntry))
+			{
+				BOOST_LOG_TRIVIAL(warning) << filename << ": broken E2E directory at " << dirPos;
+				return false;
+			}
+
+			std::vector<DirectoryEntry> entries(directory.numEntries);
+			if(!entries.empty())
+			{
+				filereader.seekg(static_cast<std::streamoff>(dirPos + sizeof(DirectoryHeader)));
+				filereader.readFStream(entries.data(), entries.size());
+				if(!filereader.good())
+					return false;
+			}
+
+			for(const DirectoryEntry& entry : entries)
+			{
+				if(entry.start <= entry.pos || entry.start + static_cast<std::size_t>(entry.size) > fileSize) // unused entry
+					continue;
+
+				if(entry.type == chunkTypePatientData)
+				{
+					std::string& patientId = patientIds[entry.patientId];
+					if(patientId.empty())
+						patientId = readPatientId(filereader, entry);
+				}
+				else if(entry.type == chunkTypeImage)
+				{
+					SeriesSummary& summary = seriesSummaries[SeriesKey(entry.patientId, entry.studyId, entry.seriesId)];
+					if(entry.ind == imageIndBScan)
+					{
+						if(summary.bscanSlices.insert(entry.sliceId).second && summary.bscanWidth == 0)
+							readImageHeader(filereader, entry, summary.bscanWidth, summary.bscanHeight);
+					}
+					else if(entry.ind == imageIndSlo && summary.sloWidth == 0)
+						readImageHeader(filereader, entry, summary.sloWidth, summary.sloHeight);
+				}
+			}
+
+			dirPos = directory.prev;
+		}
+
+		for(const std::pair<const SeriesKey, SeriesSummary>& seriesPair : seriesSummaries)
+		{
+			const SeriesSummary& summary = seriesPair.second;
+
+			probe.series.emplace_back();
+			FileProbe::SeriesInfo& info = probe.series.back();
+			info.patientId   = patientIds[std::get<0>(seriesPair.first)];
+			info.bscanCount  = summary.bscanSlices.size();
+			info.bscanWidth  = summary.bscanWidth;
+			info.bscanHeight = summary.bscanHeight;
+			info.sloWidth    = summary.sloWidth;
+			info.sloHeight   = summary.sloHeight;
+		}
+		return !probe.series.empty();
+	}
+}
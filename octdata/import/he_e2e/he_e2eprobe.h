@@ -0,0 +1,13 @@
+#pragma once
+
+namespace OctData
+{
+	class FileReader;
+	class FileProbe;
+
+	// summary of an E2E/sdb file from the directory and the chunk headers, no image data is read
+	// gives the B-scan count and the image sizes per series and the patient id; laterality, scan pattern,
+	// study/scan date and the patient/study/series UIDs are not read (their chunk layouts are not decoded here)
+	// and keep the SeriesInfo defaults
+	bool probeHeE2EFile(FileReader& filereader, FileProbe& probe);
+}
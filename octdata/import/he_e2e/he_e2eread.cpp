@@ -8,6 +8,7 @@
 #include <datastruct/sloimage.h>
 #include <datastruct/bscan.h>
 #include <filereadoptions.h>
+#include <derivedimagesettings.h>
 
 #include <iostream>
 #include <fstream>
@@ -16,6 +17,7 @@
 #include <opencv2/opencv.hpp>
 
 #include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
 
 #include <E2E/e2edata.h>
 #include <E2E/dataelements/patientdataelement.h>
@@ -30,7 +32,9 @@
 
 #include <E2E/dataelements/studydata.h>
 
+#include "he_e2eprobe.h"
 #include "he_gray_transform.h"
+#include "he_shear_transform.h"
 
 #include <boost/locale.hpp>
 #include <boost/log/trivial.hpp>
@@ -38,6 +42,7 @@
 #include <oct_cpp_framework/callback.h>
 
 #include"../platform_helper.h"
+#include"../threadpool.h"
 
 #include<filereader/filereader.h>
 
@@ -327,44 +332,86 @@ namespace OctData
 			}
 		}
 		
-		template<typename SourceType, typename DestType, typename TransformType>
-		void useLUTBScan(const cv::Mat& source, cv::Mat& dest)
+		// the rows are split in one chunk per pool thread, small images are converted in this thread
+		template<typename TransformType>
+		void useLUTBScan(const cv::Mat& source, cv::Mat& dest, ThreadPool& pool)
 		{
-			dest.create(source.rows, source.cols, cv::DataType<DestType>::type);
+			dest.create(source.rows, source.cols, cv::DataType<uint8_t>::type);
 
-			TransformType& lut = TransformType::getInstance();
-			
-			const SourceType* sPtr = source.ptr<SourceType>();
-			DestType* dPtr = dest.ptr<DestType>();
-			
-			const std::size_t size = source.cols * source.rows;
-			for(size_t i = 0; i < size; ++i)
+			const uint8_t*    lut  = TransformType::getInstance().getLut();
+			const std::size_t cols = static_cast<std::size_t>(source.cols);
+
+			pool.runChunks(static_cast<std::size_t>(source.rows), 64, [&source, &dest, lut, cols](std::size_t begin, std::size_t end)
 			{
-				*dPtr = lut.getValue(*sPtr);
-				++dPtr;
-				++sPtr;
-			}
+				for(int row = static_cast<int>(begin); row < static_cast<int>(end); ++row)
+					applyHeGrayLut(source.ptr<uint16_t>(row), dest.ptr<uint8_t>(row), cols, lut);
+			});
 		}
 
-		void transformImage(const E2E::ImageRegistration* reg, cv::Mat& image, bool fillWhite, int interpolMethod = cv::INTER_LINEAR)
+		// the registration is a horizontal shift and a vertical shear, HeShearTransform gives the pixels of cv::warpAffine
+		boost::optional<HeShearTransform> getRegistration(const E2E::ImageRegistration* reg)
 		{
 			if(!reg)
-				return;
+				return boost::none;
 
 			// std::cout << "shift X: " << reg->values[9] << std::endl;
 			double shiftY = -reg->values[3];
 			double degree = -reg->values[7];
 			double shiftX = -reg->values[9];
 			// std::cout << "shift X: " << shiftX << "\tdegree: " << degree << "\t" << (degree*bscanImageConv.cols/2) << std::endl;
-			cv::Mat trans_mat = (cv::Mat_<double>(2,3) << 1, 0, shiftY, degree, 1, shiftX - degree*image.cols/2.);
+			return HeShearTransform(shiftY, degree, shiftX);
+		}
+
+		// 8 bit B-scan image from the E2E image, also used to derive the images later (FileReadOptions::deriveBScanImages)
+		void convertBScanImage(const cv::Mat& e2eImage
+		                     , FileReadOptions::E2eGrayTransform e2eGray
+		                     , bool fillEmptyPixelWhite
+		                     , const boost::optional<HeShearTransform>& registration
+		                     , ThreadPool& pool
+		                     , cv::Mat& bscanImageConv)
+		{
+			if(e2eImage.type() == cv::DataType<float>::type)
+			{
+				cv::Mat bscanImagePow;
+				cv::pow(e2eImage, 0.25, bscanImagePow);
+				bscanImagePow.convertTo(bscanImageConv, CV_8U, 255, 0);
+			}
+			else
+			{
+				// convert image
+				switch(e2eGray)
+				{
+				case FileReadOptions::E2eGrayTransform::nativ:
+					useLUTBScan<HeGrayTransformNativ>(e2eImage, bscanImageConv, pool);
+					break;
+				case FileReadOptions::E2eGrayTransform::xml:
+					useLUTBScan<HeGrayTransformXml>(e2eImage, bscanImageConv, pool);
+					break;
+				case FileReadOptions::E2eGrayTransform::vol:
+					useLUTBScan<HeGrayTransformVol>(e2eImage, bscanImageConv, pool);
+					break;
+				case FileReadOptions::E2eGrayTransform::u16:
+					useLUTBScan<HeGrayTransformUFloat16>(e2eImage, bscanImageConv, pool);
+					break;
+				}
+				if(bscanImageConv.empty())
+				{
+					BOOST_LOG_TRIVIAL(error) << "E2E::copyBScan: Error: Converted Matrix empty, valid E2eGrayTransform option?";
+					useLUTBScan<HeGrayTransformXml>(e2eImage, bscanImageConv, pool);
+				}
+			}
+
+			if(!fillEmptyPixelWhite)
+				fillEmptyBroderCols<uint8_t>(bscanImageConv, 255, 0);
 
 			uint8_t fillValue = 0;
-			if(fillWhite)
+			if(fillEmptyPixelWhite)
 				fillValue = 255;
-			cv::warpAffine(image, image, trans_mat, image.size(), interpolMethod, cv::BORDER_CONSTANT, cv::Scalar(fillValue));
+			if(registration)
+				registration->applyLinear(bscanImageConv, bscanImageConv, fillValue, pool);
 		}
 
-		void copyBScan(Series& series, const E2E::BScan& e2eBScan, const FileReadOptions& op)
+		void copyBScan(Series& series, const E2E::BScan& e2eBScan, const FileReadOptions& op, ThreadPool& pool, const std::shared_ptr<DerivedImageSettings>& derivedImages)
 		{
 			const E2E::Image* e2eAngioImg = e2eBScan.getAngioImage();
 			const E2E::Image* e2eBScanImg = e2eBScan.getImage();
@@ -431,55 +478,37 @@ namespace OctData
 			addSegData(bscanData, Segmentationlines::SegmentlineType::PR2 , e2eSegMap, 15, 1, reg, imgCols);
 			addSegData(bscanData, Segmentationlines::SegmentlineType::RPE , e2eSegMap, 16, 1, reg, imgCols);
 
-			cv::Mat bscanImageConv;
-			if(e2eImage.type() == cv::DataType<float>::type)
+			const boost::optional<HeShearTransform> registration = getRegistration(reg);
+
+			BScan* bscan;
+			if(derivedImages)
 			{
-				cv::Mat bscanImagePow;
-				cv::pow(e2eImage, 0.25, bscanImagePow);
-				bscanImagePow.convertTo(bscanImageConv, CV_8U, 255, 0);
+				// the E2E image is the raw image, the loader derives the 8 bit image with the current settings
+				const cv::Mat rawImage = e2eImage;
+				auto deriveImage = [rawImage, registration, derivedImages](cv::Mat& image)
+				{
+					ThreadPool pool(1);
+					convertBScanImage(rawImage, derivedImages->getE2eGray(), derivedImages->getFillEmptyPixelWhite(), registration, pool, image);
+					return !image.empty();
+				};
+				bscan = new BScan(deriveImage, e2eImage.cols, e2eImage.rows, bscanData, derivedImages->getCache(), derivedImages);
+				bscan->setRawImage(rawImage);
 			}
 			else
 			{
-				cv::Mat dest;
-				// convert image
-				switch(op.e2eGray)
-				{
-				case FileReadOptions::E2eGrayTransform::nativ:
-					e2eImage.convertTo(dest, CV_32FC1, 1/static_cast<double>(1 << 16), 0);
-					cv::pow(dest, 8, dest);
-					dest.convertTo(bscanImageConv, CV_8U, 255, 0);
-					break;
-				case FileReadOptions::E2eGrayTransform::xml:
-					useLUTBScan<uint16_t, uint8_t, HeGrayTransformXml>(e2eImage, bscanImageConv);
-					break;
-				case FileReadOptions::E2eGrayTransform::vol:
-					useLUTBScan<uint16_t, uint8_t, HeGrayTransformVol>(e2eImage, bscanImageConv);
-					break;
-				case FileReadOptions::E2eGrayTransform::u16:
-					useLUTBScan<uint16_t, uint8_t, HeGrayTransformUFloat16>(e2eImage, bscanImageConv);
-					break;
-				}
-				if(bscanImageConv.empty())
-				{
-					BOOST_LOG_TRIVIAL(error) << "E2E::copyBScan: Error: Converted Matrix empty, valid E2eGrayTransform option?";
-					useLUTBScan<uint16_t, uint8_t, HeGrayTransformXml>(e2eImage, bscanImageConv);
-				}
-			}
-
-			if(!op.fillEmptyPixelWhite)
-				fillEmptyBroderCols<uint8_t>(bscanImageConv, 255, 0);
-
-			transformImage(reg, bscanImageConv, op.fillEmptyPixelWhite);
+				cv::Mat bscanImageConv;
+				convertBScanImage(e2eImage, op.e2eGray, op.fillEmptyPixelWhite, registration, pool, bscanImageConv);
 
-			BScan* bscan = new BScan(bscanImageConv, bscanData);
-			if(op.holdRawData)
-				bscan->setRawImage(e2eImage);
+				bscan = new BScan(bscanImageConv, bscanData);
+				if(op.holdRawData)
+					bscan->setRawImage(e2eImage);
+			}
 			if(e2eAngioImg)
 			{
 				cv::Mat angioImg = e2eAngioImg->getImage();
 // 				std::transform(angioImg.begin<uint8_t>(), angioImg.end<uint8_t>(), angioImg.begin<uint8_t>(), [](uint8_t v){ return v==255?0:v; });
-				if(reg)
-					transformImage(reg, angioImg, false, cv::INTER_NEAREST);
+				if(registration)
+					registration->applyNearest(angioImg, angioImg, 0);
 				bscan->setAngioImage(angioImg);
 			}
 			series.takeBScan(bscan);
@@ -492,6 +521,15 @@ namespace OctData
 	{
 	}
 
+	bool HeE2ERead::probeFile(FileReader& filereader, FileProbe& probe)
+	{
+		const boost::filesystem::path& file = filereader.getFilepath();
+		if(file.extension() != ".E2E" && file.extension() != ".sdb")
+			return false;
+
+		return probeHeE2EFile(filereader, probe);
+	}
+
 	bool HeE2ERead::readFile(FileReader& filereader, OCT& oct, const FileReadOptions& op, CppFW::Callback* callback)
 	{
 		const boost::filesystem::path& file = filereader.getFilepath();
@@ -552,6 +590,10 @@ namespace OctData
 
 
 		BOOST_LOG_TRIVIAL(debug) << "convert HEYEX data to own data structure";
+		ThreadPool pool(ThreadPool::resolveNumThreads(op.numThreads));
+		std::shared_ptr<DerivedImageSettings> derivedImages;
+		if(op.deriveBScanImages)
+			derivedImages = std::make_shared<DerivedImageSettings>(op);
 		CppFW::CallbackSubTaskCreator callbackCreatorPatients(&convertCallback, e2eRoot.size());
 		// convert e2e structure in octdata structure
 		for(const E2E::DataRoot::SubstructurePair& e2ePatPair : e2eRoot)
@@ -600,7 +642,7 @@ namespace OctData
 					CppFW::CallbackStepper bscanCallbackStepper(&callbackSeries, e2eSeries.size());
 					for(const E2E::Series::SubstructurePair& e2eBScanPair : e2eSeries)
 					{
-						copyBScan(series, *(e2eBScanPair.second), op);
+						copyBScan(series, *(e2eBScanPair.second), op, pool, derivedImages);
 						++bscanCallbackStepper;
 					}
 				}
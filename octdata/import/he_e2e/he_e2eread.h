@@ -15,6 +15,7 @@ namespace OctData
 		HeE2ERead();
 
 		virtual bool readFile(FileReader& filereader, OCT& oct, const FileReadOptions& op, CppFW::Callback* callback) override;
+		virtual bool probeFile(FileReader& filereader, FileProbe& probe) override;
 
 	};
 }
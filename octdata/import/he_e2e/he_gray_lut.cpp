@@ -0,0 +1,89 @@
+#include "he_gray_lut.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#include <immintrin.h>
+	#define HE_GRAY_LUT_RUNTIME_DISPATCH
+	#define HE_GRAY_LUT_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace OctData
+{
+	namespace
+	{
+		typedef void (*GrayLutKernel)(const uint16_t* in, uint8_t* out, std::size_t size, const uint8_t* lut);
+
+		void grayLutKernelScalar(const uint16_t* in, uint8_t* out, std::size_t size, const uint8_t* lut)
+		{
+			for(std::size_t i = 0; i < size; ++i)
+				out[i] = lut[in[i]];
+		}
+
+#ifdef HE_GRAY_LUT_RUNTIME_DISPATCH
+		// gathers 4 bytes at lut + index for 8 values and keeps the lowest one
+		HE_GRAY_LUT_TARGET("avx2")
+		inline __m256i gatherLutAVX2(const int* lut, __m128i index, __m256i lowByte)
+		{
+			return _mm256_and_si256(_mm256_i32gather_epi32(lut, _mm256_cvtepu16_epi32(index), 1), lowByte);
+		}
+
+		HE_GRAY_LUT_TARGET("avx2")
+		void grayLutKernelAVX2(const uint16_t* in, uint8_t* out, std::size_t size, const uint8_t* lut)
+		{
+			const int*    lutInt  = reinterpret_cast<const int*>(lut);
+			const __m256i lowByte = _mm256_set1_epi32(0xFF);
+			const __m256i order   = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7); // the packs work per 128 bit lane
+
+			std::size_t i = 0;
+			for(; i + 32 <= size; i += 32)
+			{
+				const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i     ));
+				const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i + 16));
+
+				const __m256i v0 = gatherLutAVX2(lutInt, _mm256_castsi256_si128(a)     , lowByte);
+				const __m256i v1 = gatherLutAVX2(lutInt, _mm256_extracti128_si256(a, 1), lowByte);
+				const __m256i v2 = gatherLutAVX2(lutInt, _mm256_castsi256_si128(b)     , lowByte);
+				const __m256i v3 = gatherLutAVX2(lutInt, _mm256_extracti128_si256(b, 1), lowByte);
+
+				const __m256i packed = _mm256_packus_epi16(_mm256_packus_epi32(v0, v1), _mm256_packus_epi32(v2, v3));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_permutevar8x32_epi32(packed, order));
+			}
+			grayLutKernelScalar(in + i, out + i, size - i, lut);
+		}
+#endif
+
+		// the AVX-512 gather is not faster than the AVX2 one for byte tables, so it is not used
+		struct GrayLutDispatch
+		{
+			GrayLutKernel kernel         = &grayLutKernelScalar;
+			const char*   instructionSet = "scalar";
+
+			GrayLutDispatch()
+			{
+#ifdef HE_GRAY_LUT_RUNTIME_DISPATCH
+				__builtin_cpu_init();
+				if(__builtin_cpu_supports("avx2"))
+				{
+					kernel         = &grayLutKernelAVX2;
+					instructionSet = "AVX2";
+				}
+#endif
+			}
+		};
+
+		const GrayLutDispatch& getDispatch()
+		{
+			static const GrayLutDispatch dispatch;
+			return dispatch;
+		}
+	}
+
+	void applyHeGrayLut(const uint16_t* in, uint8_t* out, std::size_t size, const uint8_t* lut)
+	{
+		getDispatch().kernel(in, out, size, lut);
+	}
+
+	const char* heGrayLutInstructionSet()
+	{
+		return getDispatch().instructionSet;
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace OctData
+{
+	// entries of the uint16 -> uint8 tables of the HeGrayTransform classes
+	constexpr std::size_t heGrayLutSize    = std::size_t(1) << 16;
+	// the gather kernels read 4 bytes per entry, the tables need this many zero bytes behind the last entry
+	constexpr std::size_t heGrayLutPadding = 4;
+
+	// out[i] = lut[in[i]], lut needs heGrayLutSize + heGrayLutPadding bytes
+	// the instruction set (scalar, AVX2 gather) is chosen at runtime, in and out need no alignment
+	void applyHeGrayLut(const uint16_t* in, uint8_t* out, std::size_t size, const uint8_t* lut);
+
+	// name of the instruction set used by applyHeGrayLut
+	const char* heGrayLutInstructionSet();
+}
@@ -9,7 +9,7 @@
 namespace OctData
 {
 	HeGrayTransformXml::HeGrayTransformXml()
-	: lutXML(new uint8_t[1 << sizeof(uint16_t)*8])
+	: lutXML(new uint8_t[heGrayLutSize + heGrayLutPadding]())
 	{
 		uint8_t* lutXmlIt = lutXML;
 		for(int i = 0; i <= std::numeric_limits<char16_t>::max(); ++i)
@@ -21,7 +21,7 @@ namespace OctData
 
 
 	HeGrayTransformUFloat16::HeGrayTransformUFloat16()
-	: lut(new uint8_t[1 << sizeof(uint16_t)*8])
+	: lut(new uint8_t[heGrayLutSize + heGrayLutPadding]())
 	{
 		uint8_t* lutIt = lut;
 		for(int i = 0; i <= std::numeric_limits<char16_t>::max(); ++i)
@@ -55,7 +55,7 @@ namespace OctData
 
 
 	HeGrayTransformVol::HeGrayTransformVol()
-	: lutVol(new uint8_t[1 << sizeof(uint16_t)*8])
+	: lutVol(new uint8_t[heGrayLutSize + heGrayLutPadding]())
 	{
 		uint8_t* lutVolIt = lutVol;
 		for(int i = 0; i <= std::numeric_limits<char16_t>::max(); ++i)
@@ -66,6 +66,28 @@ namespace OctData
 	}
 
 
+	HeGrayTransformNativ::HeGrayTransformNativ()
+	: lut(new uint8_t[heGrayLutSize + heGrayLutPadding]())
+	{
+		uint8_t* lutIt = lut;
+		for(int i = 0; i <= std::numeric_limits<char16_t>::max(); ++i)
+		{
+			*lutIt = getNativValue(static_cast<char16_t>(i));
+			++lutIt;
+		}
+	}
+
+	// same float operations as convertTo(CV_32F, 1/2^16) + cv::pow(8) + convertTo(CV_8U, 255)
+	uint8_t HeGrayTransformNativ::getNativValue(uint16_t val)
+	{
+		const float v  = static_cast<float>(val)*(1.f/static_cast<float>(1 << 16));
+		const float v2 = v*v;
+		const float v4 = v2*v2;
+		const float v8 = v4*v4;
+		return static_cast<uint8_t>(std::lrint(v8*255.f)); // v8 < 1
+	}
+
+
 	uint8_t HeGrayTransformXml::getXmlValue(uint16_t val)
 	{
 		if(val < 45852)
@@ -3,6 +3,8 @@
 #include <cstdint>
 #include <cmath>
 
+#include "he_gray_lut.h"
+
 namespace OctData
 {
 
@@ -21,6 +23,7 @@ namespace OctData
 		static uint8_t getXmlValue(uint16_t val);
 
 		uint8_t getValue(uint16_t val) const                     { return lutXML[val]; }
+		const uint8_t* getLut() const                            { return lutXML; }
 		
 	};
 
@@ -51,6 +54,7 @@ namespace OctData
 		}
 
 		uint8_t getValue(uint16_t val) const                     { return lutVol[val]; }
+		const uint8_t* getLut() const                            { return lutVol; }
 	};
 
 	class HeGrayTransformUFloat16
@@ -69,7 +73,26 @@ namespace OctData
 		static double  getDoubleValue(uint16_t val);
 
 		uint8_t getValue(uint16_t val) const                     { return lut[val]; }
+		const uint8_t* getLut() const                            { return lut; }
+	};
+
+	// table of the former float path: (val/2^16)^8*255, rounded
+	class HeGrayTransformNativ
+	{
+		uint8_t* lut = nullptr;
 
+		HeGrayTransformNativ();
+		~HeGrayTransformNativ()                                  { delete[] lut; }
+
+		HeGrayTransformNativ(const HeGrayTransformNativ&)            = delete;
+		HeGrayTransformNativ& operator=(const HeGrayTransformNativ&) = delete;
+
+	public:
+		static HeGrayTransformNativ& getInstance()               { static HeGrayTransformNativ instance; return instance; }
+		static uint8_t getNativValue(uint16_t val);
+
+		uint8_t getValue(uint16_t val) const                     { return lut[val]; }
+		const uint8_t* getLut() const                            { return lut; }
 	};
 
 }
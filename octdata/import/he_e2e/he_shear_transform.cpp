@@ -0,0 +1,269 @@
+#include "he_shear_transform.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "../threadpool.h"
+
+namespace OctData
+{
+	namespace
+	{
+		// fixed point of cv::warpAffine: positions in 1/1024 pixel, interpolation steps of 1/32 pixel
+		const int abBits             = 10;
+		const int abScale            = 1 << abBits;
+		const int interBits          = 5;
+		const int interSize          = 1 << interBits;
+		const int roundDeltaLinear   = abScale/interSize/2;
+		const int roundDeltaNearest  = abScale/2;
+
+		inline int roundFixed(double value)                      { return static_cast<int>(std::lrint(value*abScale)); }
+
+		// inverse map of warpAffine, computed like OpenCV does:
+		// source x = x - shiftY, source y = y - degree*x + (degree*shiftY - shiftX + degree*cols/2)
+		struct ShearMap
+		{
+			int              x0;             // fixed point source column of destination column 0
+			double           rowShift;       // source y of destination row 0
+			int              roundDelta;
+			std::vector<int> verticalDelta;  // fixed point source y offset of the columns
+
+			ShearMap(double shiftY, double degree, double shiftX, int cols, int roundDelta)
+			: x0           (roundFixed(-shiftY) + roundDelta)
+			, rowShift     (degree*shiftY - (shiftX - degree*cols/2.))
+			, roundDelta   (roundDelta)
+			, verticalDelta(static_cast<std::size_t>(cols))
+			{
+				for(int x = 0; x < cols; ++x)
+					verticalDelta[static_cast<std::size_t>(x)] = roundFixed(-degree*x);
+			}
+
+			// fixed point source y of row y without the multiple of abScale for y, the same for most rows
+			int rowDelta(int y) const                            { return roundFixed(y + rowShift) + roundDelta - y*abScale; }
+			int sourceCol() const                                { return x0 >> abBits; }
+			int horizontalWeight() const                         { return (x0 >> (abBits - interBits)) & (interSize - 1); }
+		};
+
+		// columns with the same source row offset
+		struct ColumnRun
+		{
+			int  begin;
+			int  end;
+			int  rowOffset;
+			bool integer;    // no vertical interpolation in all columns
+		};
+
+		void buildColumnRuns(int rowDelta, const std::vector<int>& verticalDelta, std::vector<int>& weights, std::vector<ColumnRun>& runs)
+		{
+			const int cols = static_cast<int>(verticalDelta.size());
+			weights.resize(verticalDelta.size());
+			runs.clear();
+			for(int x = 0; x < cols; ++x)
+			{
+				const int pos       = (rowDelta + verticalDelta[static_cast<std::size_t>(x)]) >> (abBits - interBits);
+				const int rowOffset = pos >> interBits;
+				const int weight    = pos & (interSize - 1);
+				weights[static_cast<std::size_t>(x)] = weight;
+
+				if(runs.empty() || runs.back().rowOffset != rowOffset)
+					runs.push_back(ColumnRun{x, x, rowOffset, true});
+				runs.back().end     = x + 1;
+				runs.back().integer = runs.back().integer && weight == 0;
+			}
+		}
+
+		// rows of the vertical pass, the taps of destination column x are at x + colShift for x in [colBegin, colEnd),
+		// rows outside the image are filled with the border
+		template<typename T>
+		struct TapRows
+		{
+			const cv::Mat& image;
+			int            colShift;
+			int            colBegin;
+			int            colEnd;
+			std::vector<T> fillRow;
+
+			TapRows(const cv::Mat& image, int colShift, T fillValue)
+			: image   (image)
+			, colShift(colShift)
+			, colBegin(std::min(std::max(-colShift, 0), image.cols))
+			, colEnd  (std::max(std::min(image.cols - colShift, image.cols), colBegin))
+			, fillRow (static_cast<std::size_t>(image.cols), fillValue)
+			{}
+
+			const T* row(int r) const                            { return (r >= 0 && r < image.rows) ? image.ptr<T>(r) : fillRow.data(); }
+		};
+
+		inline bool copyIntegerRun(const uint8_t* taps, uint8_t* dest, int size)
+		{
+			std::memcpy(dest, taps, static_cast<std::size_t>(size));
+			return true;
+		}
+		inline bool copyIntegerRun(const uint16_t*, uint8_t*, int) { return false; }
+
+		// dest = ((32 - ay)*tap0 + ay*tap1) / 32^n with the rounding of the 15 bit weights of OpenCV,
+		// n = 1 for the source pixels (no horizontal interpolation), 2 for the output of the horizontal pass
+		template<typename T>
+		void verticalPass(const TapRows<T>& taps, const ShearMap& map, cv::Mat& dst, uint8_t fillValue, int rowBegin, int rowEnd)
+		{
+			const int shift = sizeof(T) == 1 ? interBits : 2*interBits;
+			const int round = 1 << (shift - 1);
+
+			std::vector<int>       weights;
+			std::vector<ColumnRun> runs;
+			int  currentRowDelta = 0;
+			bool runsValid       = false;
+
+			for(int y = rowBegin; y < rowEnd; ++y)
+			{
+				const int rowDelta = map.rowDelta(y);
+				if(!runsValid || rowDelta != currentRowDelta)
+				{
+					buildColumnRuns(rowDelta, map.verticalDelta, weights, runs);
+					currentRowDelta = rowDelta;
+					runsValid       = true;
+				}
+
+				uint8_t* d = dst.ptr<uint8_t>(y);
+				for(const ColumnRun& run : runs)
+				{
+					const int lo = std::max(run.begin, taps.colBegin);
+					const int hi = std::min(run.end  , taps.colEnd  );
+					if(lo >= hi)
+					{
+						std::fill(d + run.begin, d + run.end, fillValue);
+						continue;
+					}
+					std::fill(d + run.begin, d + lo     , fillValue);
+					std::fill(d + hi       , d + run.end, fillValue);
+
+					const T* tap0 = taps.row(y + run.rowOffset    ) + taps.colShift;
+					const T* tap1 = taps.row(y + run.rowOffset + 1) + taps.colShift;
+					if(run.integer && copyIntegerRun(tap0 + lo, d + lo, hi - lo))
+						continue;
+
+					const int* w = weights.data();
+					for(int x = lo; x < hi; ++x)
+						d[x] = static_cast<uint8_t>(((interSize - w[x])*tap0[x] + w[x]*tap1[x] + round) >> shift);
+				}
+			}
+		}
+
+		// taps[x] = (32 - ax)*src[x + col] + ax*src[x + col + 1], pixels outside the image are the border
+		void horizontalPass(const cv::Mat& src, cv::Mat& taps, int col, int ax, uint8_t fillValue, int rowBegin, int rowEnd)
+		{
+			const int cols     = src.cols;
+			const int wLeft    = interSize - ax;
+			const int colBegin = std::min(std::max(-col, 0), cols);
+			const int colEnd   = std::max(std::min(cols - 1 - col, cols), colBegin);
+
+			for(int y = rowBegin; y < rowEnd; ++y)
+			{
+				const uint8_t* s = src.ptr<uint8_t>(y);
+				uint16_t*      t = taps.ptr<uint16_t>(y);
+
+				auto pixel = [s, cols, fillValue](int x) { return (x >= 0 && x < cols) ? s[x] : fillValue; };
+				for(int x = 0; x < colBegin; ++x)
+					t[x] = static_cast<uint16_t>(wLeft*pixel(x + col) + ax*pixel(x + col + 1));
+
+				const uint8_t* s0 = s + colBegin + col;
+				for(int x = colBegin; x < colEnd; ++x, ++s0)
+					t[x] = static_cast<uint16_t>(wLeft*s0[0] + ax*s0[1]);
+
+				for(int x = colEnd; x < cols; ++x)
+					t[x] = static_cast<uint16_t>(wLeft*pixel(x + col) + ax*pixel(x + col + 1));
+			}
+		}
+	}
+
+
+	HeShearTransform::HeShearTransform(double shiftY, double degree, double shiftX)
+	: shiftY(shiftY)
+	, degree(degree)
+	, shiftX(shiftX)
+	{
+	}
+
+
+	void HeShearTransform::applyLinear(const cv::Mat& src, cv::Mat& dst, uint8_t fillValue, ThreadPool& pool) const
+	{
+		const ShearMap map(shiftY, degree, shiftX, src.cols, roundDeltaLinear);
+		const std::size_t rows = static_cast<std::size_t>(src.rows);
+		cv::Mat result(src.rows, src.cols, CV_8UC1);
+
+		const int ax = map.horizontalWeight();
+		if(ax == 0)
+		{
+			// integer horizontal shift: the vertical pass reads the source image
+			const TapRows<uint8_t> tapRows(src, map.sourceCol(), fillValue);
+			pool.runChunks(rows, 64, [&](std::size_t begin, std::size_t end)
+			{
+				verticalPass(tapRows, map, result, fillValue, static_cast<int>(begin), static_cast<int>(end));
+			});
+		}
+		else
+		{
+			cv::Mat taps(src.rows, src.cols, CV_16UC1);
+			pool.runChunks(rows, 64, [&](std::size_t begin, std::size_t end)
+			{
+				horizontalPass(src, taps, map.sourceCol(), ax, fillValue, static_cast<int>(begin), static_cast<int>(end));
+			});
+
+			const TapRows<uint16_t> tapRows(taps, 0, static_cast<uint16_t>(interSize*fillValue));
+			pool.runChunks(rows, 64, [&](std::size_t begin, std::size_t end)
+			{
+				verticalPass(tapRows, map, result, fillValue, static_cast<int>(begin), static_cast<int>(end));
+			});
+		}
+		dst = result;
+	}
+
+
+	void HeShearTransform::applyNearest(const cv::Mat& src, cv::Mat& dst, uint8_t fillValue) const
+	{
+		const ShearMap map(shiftY, degree, shiftX, src.cols, roundDeltaNearest);
+		const std::size_t pixelSize = src.elemSize();
+		const int         cols      = src.cols;
+		const int         col       = map.sourceCol();
+		const int         colBegin  = std::min(std::max(-col, 0), cols);
+		const int         colEnd    = std::max(std::min(cols - col, cols), colBegin);
+		cv::Mat result(src.rows, src.cols, src.type());
+
+		std::vector<int>       weights;
+		std::vector<ColumnRun> runs;
+		int  currentRowDelta = 0;
+		bool runsValid       = false;
+
+		for(int y = 0; y < src.rows; ++y)
+		{
+			const int rowDelta = map.rowDelta(y);
+			if(!runsValid || rowDelta != currentRowDelta)
+			{
+				buildColumnRuns(rowDelta, map.verticalDelta, weights, runs);
+				currentRowDelta = rowDelta;
+				runsValid       = true;
+			}
+
+			uint8_t* d = result.ptr<uint8_t>(y);
+			for(const ColumnRun& run : runs)
+			{
+				const int sourceRow = y + run.rowOffset;
+				const int lo = std::max(run.begin, colBegin);
+				const int hi = std::min(run.end  , colEnd  );
+				if(sourceRow < 0 || sourceRow >= src.rows || lo >= hi)
+				{
+					std::memset(d + run.begin*pixelSize, fillValue, static_cast<std::size_t>(run.end - run.begin)*pixelSize);
+					continue;
+				}
+				std::memset(d + run.begin*pixelSize, fillValue, static_cast<std::size_t>(lo - run.begin)*pixelSize);
+				std::memset(d + hi       *pixelSize, fillValue, static_cast<std::size_t>(run.end - hi)*pixelSize);
+				std::memcpy(d + lo*pixelSize, src.ptr<uint8_t>(sourceRow) + (lo + col)*pixelSize, static_cast<std::size_t>(hi - lo)*pixelSize);
+			}
+		}
+		dst = result;
+	}
+}
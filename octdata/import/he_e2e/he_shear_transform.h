@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+namespace cv { class Mat; }
+
+namespace OctData
+{
+	class ThreadPool;
+
+	// registration of the E2E B-scans: a horizontal shift and a vertical shift per column
+	// gives the same pixels as cv::warpAffine with the matrix (1, 0, shiftY; degree, 1, shiftX - degree*cols/2) and a constant border,
+	// the fixed point positions (1/32 pixel) and weights of OpenCV are reproduced, but the interpolation is separated in two passes
+	class HeShearTransform
+	{
+		double shiftY;
+		double degree;
+		double shiftX;
+	public:
+		HeShearTransform(double shiftY, double degree, double shiftX);
+
+		// bilinear interpolation of CV_8UC1 images, src and dst may be the same
+		void applyLinear (const cv::Mat& src, cv::Mat& dst, uint8_t fillValue, ThreadPool& pool) const;
+		// nearest neighbor for all single plane types, the border pixels get fillValue in each byte
+		void applyNearest(const cv::Mat& src, cv::Mat& dst, uint8_t fillValue) const;
+	};
+}
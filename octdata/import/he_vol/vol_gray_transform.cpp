@@ -0,0 +1,160 @@
+#include "vol_gray_transform.h"
+
+#include <cmath>
+#include <limits>
+
+#include <emmintrin.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#include <immintrin.h>
+	#define VOL_GRAY_RUNTIME_DISPATCH
+	#define VOL_GRAY_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace OctData
+{
+	namespace
+	{
+		typedef void (*GrayTransformKernel)(const float* in, uint8_t* out, std::size_t size, bool clampToOne);
+
+		// rounding and saturation of cvRound + saturate_cast, out of range values give INT_MIN like cvtps2dq
+		uint8_t grayTransformScalar(float value, bool clampToOne)
+		{
+			if(clampToOne && value > 1.f)
+				value = 1.f;
+
+			const float scaled = std::sqrt(std::sqrt(value))*255.f;
+			if(!(scaled >= -2147483648.f && scaled < 2147483648.f))
+				return 0;
+
+			const long rounded = std::lrint(scaled);
+			if(rounded < 0)
+				return 0;
+			if(rounded > 255)
+				return 255;
+			return static_cast<uint8_t>(rounded);
+		}
+
+		void grayTransformTail(const float* in, uint8_t* out, std::size_t size, bool clampToOne)
+		{
+			for(std::size_t i = 0; i < size; ++i)
+				out[i] = grayTransformScalar(in[i], clampToOne);
+		}
+
+		// min(one, x) keeps NaN like THRESH_TRUNC
+		inline __m128i grayTransformSSE2(__m128 value, __m128 one, __m128 scale, bool clampToOne)
+		{
+			if(clampToOne)
+				value = _mm_min_ps(one, value);
+			return _mm_cvtps_epi32(_mm_mul_ps(_mm_sqrt_ps(_mm_sqrt_ps(value)), scale));
+		}
+
+		void grayTransformKernelSSE2(const float* in, uint8_t* out, std::size_t size, bool clampToOne)
+		{
+			const __m128 one   = _mm_set1_ps(1.f);
+			const __m128 scale = _mm_set1_ps(255.f);
+
+			std::size_t i = 0;
+			for(; i + 16 <= size; i += 16)
+			{
+				const __m128i v0 = grayTransformSSE2(_mm_loadu_ps(in + i     ), one, scale, clampToOne);
+				const __m128i v1 = grayTransformSSE2(_mm_loadu_ps(in + i +  4), one, scale, clampToOne);
+				const __m128i v2 = grayTransformSSE2(_mm_loadu_ps(in + i +  8), one, scale, clampToOne);
+				const __m128i v3 = grayTransformSSE2(_mm_loadu_ps(in + i + 12), one, scale, clampToOne);
+
+				const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(v0, v1), _mm_packs_epi32(v2, v3));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+			}
+			grayTransformTail(in + i, out + i, size - i, clampToOne);
+		}
+
+#ifdef VOL_GRAY_RUNTIME_DISPATCH
+		VOL_GRAY_TARGET("avx2")
+		inline __m256i grayTransformAVX2(__m256 value, __m256 one, __m256 scale, bool clampToOne)
+		{
+			if(clampToOne)
+				value = _mm256_min_ps(one, value);
+			return _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_sqrt_ps(_mm256_sqrt_ps(value)), scale));
+		}
+
+		VOL_GRAY_TARGET("avx2")
+		void grayTransformKernelAVX2(const float* in, uint8_t* out, std::size_t size, bool clampToOne)
+		{
+			const __m256  one   = _mm256_set1_ps(1.f);
+			const __m256  scale = _mm256_set1_ps(255.f);
+			const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7); // the packs work per 128 bit lane
+
+			std::size_t i = 0;
+			for(; i + 32 <= size; i += 32)
+			{
+				const __m256i v0 = grayTransformAVX2(_mm256_loadu_ps(in + i     ), one, scale, clampToOne);
+				const __m256i v1 = grayTransformAVX2(_mm256_loadu_ps(in + i +  8), one, scale, clampToOne);
+				const __m256i v2 = grayTransformAVX2(_mm256_loadu_ps(in + i + 16), one, scale, clampToOne);
+				const __m256i v3 = grayTransformAVX2(_mm256_loadu_ps(in + i + 24), one, scale, clampToOne);
+
+				const __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(v0, v1), _mm256_packs_epi32(v2, v3));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_permutevar8x32_epi32(packed, order));
+			}
+			grayTransformKernelSSE2(in + i, out + i, size - i, clampToOne);
+		}
+
+		VOL_GRAY_TARGET("avx512f")
+		void grayTransformKernelAVX512(const float* in, uint8_t* out, std::size_t size, bool clampToOne)
+		{
+			const __m512  one   = _mm512_set1_ps(1.f);
+			const __m512  scale = _mm512_set1_ps(255.f);
+			const __m512i zero  = _mm512_setzero_si512();
+
+			std::size_t i = 0;
+			for(; i + 16 <= size; i += 16)
+			{
+				__m512 value = _mm512_loadu_ps(in + i);
+				if(clampToOne)
+					value = _mm512_min_ps(one, value);
+				const __m512i rounded = _mm512_cvtps_epi32(_mm512_mul_ps(_mm512_sqrt_ps(_mm512_sqrt_ps(value)), scale));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm512_cvtusepi32_epi8(_mm512_max_epi32(rounded, zero)));
+			}
+			grayTransformKernelSSE2(in + i, out + i, size - i, clampToOne);
+		}
+#endif
+
+		struct GrayTransformDispatch
+		{
+			GrayTransformKernel kernel          = &grayTransformKernelSSE2;
+			const char*         instructionSet  = "SSE2";
+
+			GrayTransformDispatch()
+			{
+#ifdef VOL_GRAY_RUNTIME_DISPATCH
+				__builtin_cpu_init();
+				if(__builtin_cpu_supports("avx512f"))
+				{
+					kernel         = &grayTransformKernelAVX512;
+					instructionSet = "AVX-512";
+				}
+				else if(__builtin_cpu_supports("avx2"))
+				{
+					kernel         = &grayTransformKernelAVX2;
+					instructionSet = "AVX2";
+				}
+#endif
+			}
+		};
+
+		const GrayTransformDispatch& getDispatch()
+		{
+			static const GrayTransformDispatch dispatch;
+			return dispatch;
+		}
+	}
+
+	void volGrayTransform(const float* in, uint8_t* out, std::size_t size, bool clampToOne)
+	{
+		getDispatch().kernel(in, out, size, clampToOne);
+	}
+
+	const char* volGrayTransformInstructionSet()
+	{
+		return getDispatch().instructionSet;
+	}
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace OctData
+{
+	// fused conversion of the float vol pixels to 8 bit: (clamp to 1) -> x^0.25 -> *255 -> round, saturate,
+	// same result as cv::threshold(THRESH_TRUNC, 1) + pow(0.25) + convertTo(CV_8U, 255) in one pass;
+	// pixels out of the int range (empty pixels without clamp) and NaN give 0
+	// the instruction set (SSE2, AVX2, AVX-512) is chosen at runtime, in and out need no alignment
+	void volGrayTransform(const float* in, uint8_t* out, std::size_t size, bool clampToOne);
+
+	// name of the instruction set used by volGrayTransform
+	const char* volGrayTransformInstructionSet();
+}
@@ -5,6 +5,10 @@
 #include <datastruct/bscan.h>
 
 #include <ostream>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <memory>
 #include <thread>
 #include <chrono>
 #include <ctime>
@@ -19,12 +23,17 @@
 #include <boost/log/trivial.hpp>
 #include <boost/lexical_cast.hpp>
 
-#include <emmintrin.h>
 #include <oct_cpp_framework/callback.h>
 
 #include<boost/optional.hpp>
 
 #include<filereader/filereader.h>
+#include<fileprobe.h>
+#include"../lazybscanloader.h"
+#include"../threadpool.h"
+#include"vol_gray_transform.h"
+#include<datastruct/float16.h>
+#include<derivedimagesettings.h>
 
 namespace bfs = boost::filesystem;
 
@@ -236,67 +245,235 @@ namespace
 	}
 
 
-	void simdQuadRoot(const cv::Mat& in, cv::Mat& out)
+	typedef boost::optional<OctData::Segmentationlines::SegmentlineType> SegLineOpt;
+	const SegLineOpt volSegLines[] =
 	{
-		if(in.type() == cv::DataType<float>::type)
+		OctData::Segmentationlines::SegmentlineType::ILM ,   // 0
+		OctData::Segmentationlines::SegmentlineType::BM  ,   // 1
+		OctData::Segmentationlines::SegmentlineType::RNFL,   // 2
+		OctData::Segmentationlines::SegmentlineType::GCL ,   // 3
+		OctData::Segmentationlines::SegmentlineType::IPL ,   // 4
+		OctData::Segmentationlines::SegmentlineType::INL ,   // 5
+		OctData::Segmentationlines::SegmentlineType::OPL ,   // 6
+		SegLineOpt()                                     ,   // 7
+		OctData::Segmentationlines::SegmentlineType::ELM ,   // 8
+		SegLineOpt()                                     ,   // 9
+		SegLineOpt()                                     ,   // 10
+		SegLineOpt()                                     ,   // 11
+		SegLineOpt()                                     ,   // 12
+		SegLineOpt()                                     ,   // 13
+		OctData::Segmentationlines::SegmentlineType::PR1 ,   // 14
+		OctData::Segmentationlines::SegmentlineType::PR2 ,   // 15
+		OctData::Segmentationlines::SegmentlineType::RPE     // 16
+	};
+	const int numVolSegLines = static_cast<int>(sizeof(volSegLines)/sizeof(volSegLines[0]));
+
+	// segValues: the segmentation lines of the B-scan as stored in the file (sizeX values per line)
+	void convertSegmentationLines(const std::vector<float>& segValues, std::size_t sizeX, OctData::BScan::Data& bscanData)
+	{
+		const std::size_t numSeg = sizeX > 0 ? segValues.size()/sizeX : 0;
+		for(std::size_t segNum = 0; segNum < numSeg; ++segNum)
 		{
-			out.create(in.size(), in.type());
+			if(!volSegLines[segNum])
+				continue;
 
-			std::size_t size = in.rows*in.cols;
-			const float* dataPtr = in .ptr<float>(0);
-			      float* outPtr  = out.ptr<float>(0);
+			const std::vector<float>::const_iterator segBegin = segValues.begin() + static_cast<std::ptrdiff_t>(segNum*sizeX);
+			OctData::Segmentationlines::Segmentline segVec(sizeX);
+			std::transform(segBegin, segBegin + static_cast<std::ptrdiff_t>(sizeX), segVec.begin()
+			            , [](float value) -> OctData::Segmentationlines::SegmentlineDataType { if(value > 1e20) return std::numeric_limits<double>::quiet_NaN(); return value; });
 
-			// SIMD
-			std::size_t nb_iters = size / 4;
-			const __m128* ptr = reinterpret_cast<const __m128*>(dataPtr);
-			for(std::size_t i = 0; i < nb_iters; ++i)
+			bscanData.getSegmentLine(*(volSegLines[segNum])) = std::move(segVec);
+		}
+	}
+
+	// bscanImage: the float image for holdRawData (clamped with fillEmptyPixelWhite), as IEEE half for rawStorage float16
+	void transformBScanImage(const cv::Mat& bscanImageFile, bool fillEmptyPixelWhite, bool holdRawData, bool rawFloat16, cv::Mat& bscanImageConv, cv::Mat& bscanImage)
+	{
+		if(holdRawData && rawFloat16)
+		{
+			const std::size_t cols = static_cast<std::size_t>(bscanImageFile.cols);
+			std::vector<float> clampedRow(fillEmptyPixelWhite ? cols : 0);
+			bscanImage.create(bscanImageFile.rows, bscanImageFile.cols, cv::DataType<uint16_t>::type);
+			for(int row = 0; row < bscanImageFile.rows; ++row)
 			{
-				_mm_store_ps(outPtr, _mm_sqrt_ps(_mm_sqrt_ps(*ptr)));
-				++ptr;
-				outPtr  += 4;
+				const float* source = bscanImageFile.ptr<float>(row);
+				if(fillEmptyPixelWhite)
+				{
+					std::transform(source, source + cols, clampedRow.begin(), [](float value) { return value > 1.f ? 1.f : value; }); // like THRESH_TRUNC
+					source = clampedRow.data();
+				}
+				OctData::convertFloatToHalf(source, bscanImage.ptr<uint16_t>(row), cols);
 			}
+		}
+		else if(holdRawData)
+		{
+			if(fillEmptyPixelWhite)
+				cv::threshold(bscanImageFile, bscanImage, 1.0, 1.0, cv::THRESH_TRUNC); // schneide hohe werte ab, sonst: bei der konvertierung werden sie auf 0 gesetzt
+			else
+				bscanImage = bscanImageFile.clone();
+		}
+
+		// clamp, x^0.25 and conversion to 8 bit in one pass
+		bscanImageConv.create(bscanImageFile.rows, bscanImageFile.cols, CV_8U);
+		for(int row = 0; row < bscanImageFile.rows; ++row)
+			OctData::volGrayTransform(bscanImageFile.ptr<float>(row), bscanImageConv.ptr<uint8_t>(row), static_cast<std::size_t>(bscanImageFile.cols), fillEmptyPixelWhite);
+	}
+
+	void readBScanImage(OctData::FileReader& filereader, std::size_t sizeX, std::size_t sizeZ, bool fillEmptyPixelWhite, cv::Mat& bscanImageConv)
+	{
+		cv::Mat bscanImageFile; // view into the file, only valid while the file is open
+		cv::Mat bscanImage;
+		filereader.readCVImageView<float>(bscanImageFile, sizeZ, sizeX);
+		transformBScanImage(bscanImageFile, fillEmptyPixelWhite, false, false, bscanImageConv, bscanImage);
+	}
+
+	typedef std::shared_ptr<std::vector<char>> BlockBuffer;
+
+	// undecoded data of one B-scan, read in file order and decoded by the thread pool
+	struct BScanBlock
+	{
+		OctData::BScan::Data data;
+		std::vector<float>   segValues;
+		BlockBuffer          fileData;  // empty for memory mapped files
+		cv::Mat              imageFile; // view into the memory mapped file or into fileData
+	};
+
+	// provides the data of the B-scans in file order: for memory mapped files a pointer into the mapping,
+	// else the B-scans are read in batches of up to maxBatchBytes (submitted together with io_uring)
+	class BScanBlockReader
+	{
+		static const std::size_t maxBatchBytes = 64*1024*1024;
+
+		OctData::FileReader& filereader;
+		const std::size_t    firstPos;
+		const std::size_t    stride;
+		const std::size_t    blockSize;
+		const std::size_t    numBlocks;
+		const std::size_t    batchBlocks;
+		const bool           mappedFile;
 
-			// handel rest
-			outPtr = out.ptr<float>(0);
+		std::vector<BlockBuffer> batch;
+		std::size_t              batchBegin = 0;
+		std::size_t              batchRead  = 0;
 
-			for(std::size_t pos = nb_iters*4; pos<size; ++pos)
+		void readBatch(std::size_t first)
+		{
+			batchBegin = first;
+			batch.resize(std::min(batchBlocks, numBlocks - first));
+
+			std::vector<OctData::FileReader::ReadRequest> requests(batch.size());
+			for(std::size_t i = 0; i < batch.size(); ++i)
 			{
-				outPtr[pos] = std::sqrt(std::sqrt(dataPtr[pos]));
+				batch[i] = std::make_shared<std::vector<char>>(blockSize);
+				requests[i].offset = static_cast<std::streamoff>(firstPos + (first + i)*stride);
+				requests[i].size   = static_cast<std::streamsize>(blockSize);
+				requests[i].dest   = batch[i]->data();
 			}
+			batchRead = filereader.readBatch(requests);
 		}
-		else
+
+	public:
+		BScanBlockReader(OctData::FileReader& filereader, std::size_t firstPos, std::size_t stride, std::size_t blockSize, std::size_t numBlocks)
+		: filereader (filereader)
+		, firstPos   (firstPos  )
+		, stride     (stride    )
+		, blockSize  (blockSize )
+		, numBlocks  (numBlocks )
+		, batchBlocks(std::max<std::size_t>(1, maxBatchBytes/std::max<std::size_t>(1, blockSize)))
+		, mappedFile (filereader.isMemoryMapped())
+		{}
+
+		// nullptr if the block can't be read, buffer holds the data for not mapped files
+		const char* getBlock(std::size_t num, BlockBuffer& buffer)
 		{
-			cv::pow(in, 0.25, out);
-		}
-	}
-}
+			if(mappedFile)
+				return filereader.getMappedData(static_cast<std::streamoff>(firstPos + num*stride), blockSize);
 
+			if(batch.empty() || num < batchBegin || num >= batchBegin + batch.size())
+				readBatch(num);
 
+			const std::size_t batchIndex = num - batchBegin;
+			if(batchIndex >= batchRead)
+				return nullptr;
 
-namespace OctData
-{
-	VOLRead::VOLRead()
-	: OctFileReader(OctExtension{".vol", ".vol.gz", "Heidelberg Engineering Raw File"})
+			buffer = batch[batchIndex];
+			return buffer->data();
+		}
+	};
+
+	// 8 bit image from the unclamped raw image of deriveBScanImages (float or IEEE half)
+	void deriveBScanImage(const cv::Mat& rawImage, bool rawFloat16, bool fillEmptyPixelWhite, cv::Mat& bscanImageConv)
 	{
+		const std::size_t cols = static_cast<std::size_t>(rawImage.cols);
+		std::vector<float> floatRow(rawFloat16 ? cols : 0);
+		bscanImageConv.create(rawImage.rows, rawImage.cols, CV_8U);
+		for(int row = 0; row < rawImage.rows; ++row)
+		{
+			const float* source;
+			if(rawFloat16)
+			{
+				OctData::convertHalfToFloat(rawImage.ptr<uint16_t>(row), floatRow.data(), cols);
+				source = floatRow.data();
+			}
+			else
+				source = rawImage.ptr<float>(row);
+			OctData::volGrayTransform(source, bscanImageConv.ptr<uint8_t>(row), cols, fillEmptyPixelWhite);
+		}
 	}
 
-	bool VOLRead::readFile(FileReader& filereader, OCT& oct, const FileReadOptions& op, CppFW::Callback* callback)
+	// with deriveBScanImages only the unclamped raw image is held, the 8 bit image is derived on access with the current fillEmptyPixelWhite
+	std::unique_ptr<OctData::BScan> createDerivedBScan(BScanBlock& block, bool rawFloat16, const std::shared_ptr<OctData::DerivedImageSettings>& derivedImages)
 	{
-//
-//     BOOST_LOG_TRIVIAL(trace) << "A trace severity message";
-//     BOOST_LOG_TRIVIAL(debug) << "A debug severity message";
-//     BOOST_LOG_TRIVIAL(info) << "An informational severity message";
-//     BOOST_LOG_TRIVIAL(warning) << "A warning severity message";
-//     BOOST_LOG_TRIVIAL(error) << "An error severity message";
-//     BOOST_LOG_TRIVIAL(fatal) << "A fatal severity message";
+		cv::Mat rawImage;
+		if(rawFloat16)
+		{
+			rawImage.create(block.imageFile.rows, block.imageFile.cols, cv::DataType<uint16_t>::type);
+			for(int row = 0; row < block.imageFile.rows; ++row)
+				OctData::convertFloatToHalf(block.imageFile.ptr<float>(row), rawImage.ptr<uint16_t>(row), static_cast<std::size_t>(block.imageFile.cols));
+		}
+		else
+			rawImage = block.imageFile.clone();
 
-		if(filereader.getExtension() != ".vol")
-			return false;
+		auto deriveImage = [rawImage, rawFloat16, derivedImages](cv::Mat& image)
+		{
+			deriveBScanImage(rawImage, rawFloat16, derivedImages->getFillEmptyPixelWhite(), image);
+			return !image.empty();
+		};
+		std::unique_ptr<OctData::BScan> bscan(new OctData::BScan(deriveImage, rawImage.cols, rawImage.rows, block.data, derivedImages->getCache(), derivedImages));
+		bscan->setRawImage(rawImage, rawFloat16 ? OctData::BScan::RawImageEncoding::Float16 : OctData::BScan::RawImageEncoding::Native);
+		return bscan;
+	}
+
+	std::unique_ptr<OctData::BScan> decodeBScanBlock(BScanBlock& block, std::size_t sizeX, bool fillEmptyPixelWhite, bool holdRawData, bool rawFloat16
+	                                               , const std::shared_ptr<OctData::DerivedImageSettings>& derivedImages)
+	{
+		convertSegmentationLines(block.segValues, sizeX, block.data);
+
+		if(derivedImages)
+		{
+			std::unique_ptr<OctData::BScan> bscan = createDerivedBScan(block, rawFloat16, derivedImages);
+			block.imageFile.release();
+			return bscan;
+		}
+
+		cv::Mat bscanImage;
+		cv::Mat bscanImageConv;
+		transformBScanImage(block.imageFile, fillEmptyPixelWhite, holdRawData, rawFloat16, bscanImageConv, bscanImage);
+		block.imageFile.release();
+
+		std::unique_ptr<OctData::BScan> bscan(new OctData::BScan(bscanImageConv, block.data));
+		if(holdRawData)
+			bscan->setRawImage(bscanImage, rawFloat16 ? OctData::BScan::RawImageEncoding::Float16 : OctData::BScan::RawImageEncoding::Native);
+		return bscan;
+	}
 
+	// checks the file format and reads the vol file header, the stream is left after the header data
+	bool readVolHeader(OctData::FileReader& filereader, VolHeader& volHeader)
+	{
 		const std::string filename = filereader.getFilepath().generic_string();
 		BOOST_LOG_TRIVIAL(trace) << "Try to open OCT file as vol";
 
-		if(!filereader.openFile())
+		if(!filereader.openFile(true))
 		{
 			BOOST_LOG_TRIVIAL(error) << "Can't open vol file " << filename;
 			return false;
@@ -322,11 +499,59 @@ namespace OctData
 			return false;
 		}
 
-		VolHeader volHeader;
-
 		filereader.readFStream(&(volHeader.data));
 // 		volHeader.printData(std::cout);
 		BOOST_LOG_TRIVIAL(info) << "HSF file version: " << volHeader.data.version;
+		return true;
+	}
+}
+
+
+
+namespace OctData
+{
+	VOLRead::VOLRead()
+	: OctFileReader(OctExtension{".vol", ".vol.gz", "Heidelberg Engineering Raw File"})
+	{
+		addSignature(0, "HSF-OCT-");
+	}
+
+	bool VOLRead::probeFile(FileReader& filereader, FileProbe& probe)
+	{
+		VolHeader volHeader;
+		if(!readVolHeader(filereader, volHeader))
+			return false;
+
+		OCT oct;
+		Patient& pat    = oct.getPatient(volHeader.data.pid);
+		Study&   study  = pat.getStudy(volHeader.data.vid);
+		Series&  series = study.getSeries(1);
+		copyMetaData(volHeader, pat, study, series);
+
+		FileProbe::SeriesInfo& info = probe.addSeries(pat, study, series);
+		info.bscanCount  = volHeader.data.numBScans;
+		info.bscanWidth  = volHeader.data.sizeX;
+		info.bscanHeight = volHeader.data.sizeZ;
+		info.sloWidth    = volHeader.data.sizeXSlo;
+		info.sloHeight   = volHeader.data.sizeYSlo;
+		return true;
+	}
+
+	bool VOLRead::readFile(FileReader& filereader, OCT& oct, const FileReadOptions& op, CppFW::Callback* callback)
+	{
+//
+//     BOOST_LOG_TRIVIAL(trace) << "A trace severity message";
+//     BOOST_LOG_TRIVIAL(debug) << "A debug severity message";
+//     BOOST_LOG_TRIVIAL(info) << "An informational severity message";
+//     BOOST_LOG_TRIVIAL(warning) << "A warning severity message";
+//     BOOST_LOG_TRIVIAL(error) << "An error severity message";
+//     BOOST_LOG_TRIVIAL(fatal) << "A fatal severity message";
+
+		VolHeader volHeader;
+		if(!readVolHeader(filereader, volHeader))
+			return false;
+
+		const std::string filename = filereader.getFilepath().generic_string();
 		filereader.seekg(VolHeader::getHeaderSize());
 
 		Patient& pat    = oct.getPatient(volHeader.data.pid);
@@ -348,6 +573,43 @@ namespace OctData
 
 
 		const std::size_t numBScans = op.readBScans?volHeader.data.numBScans:1;
+
+		std::unique_ptr<LazyBScanLoader> lazyLoader;
+		if(LazyBScanLoader::useLazyLoading(op))
+		{
+			lazyLoader.reset(new LazyBScanLoader(filereader, op));
+			if(!lazyLoader->isOpen())
+				lazyLoader.reset();
+		}
+
+		const std::size_t sizeX = volHeader.data.sizeX;
+		const std::size_t sizeZ = volHeader.data.sizeZ;
+		const bool fillEmptyPixelWhite = op.fillEmptyPixelWhite;
+		const bool holdRawData         = op.holdRawData;
+		const bool rawFloat16          = op.rawStorage == FileReadOptions::RawStorage::float16;
+
+		std::shared_ptr<DerivedImageSettings> derivedImages;
+		if(op.deriveBScanImages && !lazyLoader)
+			derivedImages = std::make_shared<DerivedImageSettings>(op);
+
+		// lazy B-scans need only the B-scan header with the segmentation lines
+		const std::size_t bscanHdrSize = volHeader.data.bScanHdrSize;
+		BScanBlockReader blockReader(filereader
+		                           , VolHeader::getHeaderSize() + volHeader.getSLOPixelSize()
+		                           , volHeader.getBScanSize()
+		                           , lazyLoader ? std::max(bscanHdrSize, sizeof(BScanHeader::Data)) : volHeader.getBScanSize()
+		                           , numBScans);
+
+		// the file is read sequentially in this thread, the pixel data is decoded by the pool and committed in file order
+		ThreadPool threadPool(lazyLoader ? 1 : ThreadPool::resolveNumThreads(op.numThreads));
+		const std::size_t maxPendingBScans = 2*threadPool.numThreads();
+		std::deque<std::future<std::unique_ptr<BScan>>> pendingBScans;
+		auto commitBScan = [&series, &pendingBScans]()
+		{
+			series.takeBScan(pendingBScans.front().get().release());
+			pendingBScans.pop_front();
+		};
+
 		// Read BScann
 		for(std::size_t numBscan = 0; numBscan<numBScans; ++numBscan)
 		{
@@ -362,14 +624,18 @@ namespace OctData
 			}
 
 			BScanHeader bscanHeader;
-			BScan::Data bscanData;
+			std::shared_ptr<BScanBlock> block = std::make_shared<BScanBlock>();
+			BScan::Data& bscanData = block->data;
 
 			std::size_t bscanPos = VolHeader::getHeaderSize() + volHeader.getSLOPixelSize() + numBscan*volHeader.getBScanSize();
 
 // 			std::cout << "bscanPos: " << bscanPos << std::endl;
 
-			filereader.seekg(bscanPos);
-			filereader.readFStream(&(bscanHeader.data));
+			const char* blockData = blockReader.getBlock(numBscan, block->fileData);
+			if(!blockData)
+				break;
+
+			std::memcpy(&(bscanHeader.data), blockData, sizeof(bscanHeader.data));
 
 			if(memcmp(bscanHeader.data.hsfOctRawStr, "HSF-BS-", BScanHeader::identiferSize) != 0) // 0 = strings are equal
 			{
@@ -382,60 +648,11 @@ namespace OctData
 			// bscanHeader.printData();
 
 
-			typedef boost::optional<Segmentationlines::SegmentlineType> SegLineOpt;
-			const SegLineOpt seglines[] =
-			{
-				Segmentationlines::SegmentlineType::ILM ,   // 0
-				Segmentationlines::SegmentlineType::BM  ,   // 1
-				Segmentationlines::SegmentlineType::RNFL,   // 2
-				Segmentationlines::SegmentlineType::GCL ,   // 3
-				Segmentationlines::SegmentlineType::IPL ,   // 4
-				Segmentationlines::SegmentlineType::INL ,   // 5
-				Segmentationlines::SegmentlineType::OPL ,   // 6
-				SegLineOpt()                            ,   // 7
-				Segmentationlines::SegmentlineType::ELM ,   // 8
-				SegLineOpt()                            ,   // 9
-				SegLineOpt()                            ,   // 10
-				SegLineOpt()                            ,   // 11
-				SegLineOpt()                            ,   // 12
-				SegLineOpt()                            ,   // 13
-				Segmentationlines::SegmentlineType::PR1 ,   // 14
-				Segmentationlines::SegmentlineType::PR2 ,   // 15
-				Segmentationlines::SegmentlineType::RPE     // 16
-			};
-
-			filereader.seekg(256+bscanPos);
-			const int maxSeg = std::min(static_cast<int>(sizeof(seglines)/sizeof(seglines[0])), bscanHeader.data.numSeg);
-			for(int segNum = 0; segNum < maxSeg; ++segNum)
-			{
-				Segmentationlines::Segmentline segVec;
-				segVec.reserve(volHeader.data.sizeX);
-				float value;
-				for(std::size_t xpos = 0; xpos<volHeader.data.sizeX; ++xpos)
-				{
-					filereader.readFStream(&value);
-					segVec.push_back(value);
-				}
-
-				std::transform(segVec.begin(), segVec.end(), segVec.begin()
-				            , [](Segmentationlines::SegmentlineDataType value) { if(value > 1e20) return std::numeric_limits<double>::quiet_NaN(); return value; });
-
-
-				if(seglines[segNum])
-					bscanData.getSegmentLine(*(seglines[segNum])) = std::move(segVec);
-			}
-
-			filereader.seekg(volHeader.data.bScanHdrSize+bscanPos);
-			cv::Mat bscanImage;
-			cv::Mat bscanImagePow;
-			cv::Mat bscanImageConv;
-			filereader.readCVImage<float>(bscanImage, volHeader.data.sizeZ, volHeader.data.sizeX);
-
-			if(op.fillEmptyPixelWhite)
-				cv::threshold(bscanImage, bscanImage, 1.0, 1.0, cv::THRESH_TRUNC); // schneide hohe werte ab, sonst: bei der konvertierung werden sie auf 0 gesetzt
-			// cv::pow(bscanImage, 0.25, bscanImagePow);
-			simdQuadRoot(bscanImage, bscanImagePow);
-			bscanImagePow.convertTo(bscanImageConv, CV_8U, 255, 0);
+			// the segmentation lines start at 256 in the B-scan header
+			const std::size_t segSpace = bscanHdrSize > 256 ? (bscanHdrSize - 256)/(sizeX*sizeof(float)) : 0;
+			const int maxSeg = std::max(0, std::min(std::min(numVolSegLines, bscanHeader.data.numSeg), static_cast<int>(segSpace)));
+			block->segValues.resize(sizeX*static_cast<std::size_t>(maxSeg));
+			std::memcpy(block->segValues.data(), blockData + 256, block->segValues.size()*sizeof(float));
 
 			bscanData.start       = CoordSLOmm(bscanHeader.data.startX, bscanHeader.data.startY);
 
@@ -456,16 +673,36 @@ namespace OctData
 			bscanData.scaleFactor = ScaleFactor(volHeader.data.scaleX, volHeader.data.distance, volHeader.data.scaleZ);
 			bscanData.imageQuality = bscanHeader.data.quality;
 
+			const std::size_t imagePos = volHeader.data.bScanHdrSize+bscanPos;
 
-			if(!filereader.good())
-				break;
+			if(lazyLoader)
+			{
+				if(imagePos + volHeader.getBScanPixelSize() > filereader.file_size())
+					break;
+
+				convertSegmentationLines(block->segValues, sizeX, bscanData);
+
+				auto decode = [imagePos, sizeX, sizeZ, fillEmptyPixelWhite](FileReader& reader, cv::Mat& image)
+				{
+					reader.seekg(imagePos);
+					readBScanImage(reader, sizeX, sizeZ, fillEmptyPixelWhite, image);
+					return reader.good();
+				};
+				series.takeBScan(lazyLoader->createBScan(decode, static_cast<int>(sizeX), static_cast<int>(sizeZ), bscanData));
+				continue;
+			}
 
-			BScan* bscan = new BScan(bscanImageConv, bscanData);
-			if(op.holdRawData)
-				bscan->setRawImage(bscanImage);
-			series.takeBScan(bscan);
+			block->imageFile = cv::Mat(static_cast<int>(sizeZ), static_cast<int>(sizeX), cv::DataType<float>::type, const_cast<char*>(blockData + bscanHdrSize));
+
+			pendingBScans.push_back(threadPool.submit([block, sizeX, fillEmptyPixelWhite, holdRawData, rawFloat16, derivedImages]()
+			                                          { return decodeBScanBlock(*block, sizeX, fillEmptyPixelWhite, holdRawData, rawFloat16, derivedImages); }));
+			if(pendingBScans.size() >= maxPendingBScans)
+				commitBScan();
 		}
 
+		while(!pendingBScans.empty())
+			commitBScan();
+
 		if(volHeader.data.gridType > 0 && volHeader.data.gridOffset > 2000)
 		{
 			ThicknessGrid grid;
@@ -11,6 +11,8 @@ namespace OctData
 		VOLRead();
 
 	    virtual bool readFile(FileReader& filereader, OCT& oct, const FileReadOptions& op, CppFW::Callback* callback) override;
+	    virtual bool probeFile(FileReader& filereader, FileProbe& probe) override;
+	    virtual bool supportsLazyBScans() const override { return true; }
 	};
 }
 
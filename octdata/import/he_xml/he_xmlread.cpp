@@ -27,6 +27,7 @@
 
 
 #include<filereader/filereader.h>
+#include<fileprobe.h>
 
 
 namespace bfs = boost::filesystem;
@@ -218,135 +219,155 @@ namespace OctData
 
 		}
 
-	}
+		// without probe the images are loaded, else only the series are summarized in probe
+		bool readHeXml(const bfs::path& file, OCT& oct, const FileReadOptions& op, CppFW::Callback* callback, FileProbe* probe)
+		{
+			if(file.extension() != ".xml")
+				return false;
 
 
+			BOOST_LOG_TRIVIAL(trace) << "Try to open Heidelberg Engineering Xml file as vol";
 
-	HeXmlRead::HeXmlRead()
-	: OctFileReader(OctExtension(".xml", "Heidelberg Engineering Xml File"))
-	{
-	}
+			std::string xmlPath     = file.branch_path().generic_string();
+			// std::string xmlFilename = file.filename().generic_string();
 
-	bool HeXmlRead::readFile(FileReader& filereader, OCT& oct, const FileReadOptions& op, CppFW::Callback* callback)
-	{
-		const boost::filesystem::path& file = filereader.getFilepath();
-		if(file.extension() != ".xml")
-			return false;
+			// Create an empty property tree object
+			bpt::ptree pt;
 
 
-		BOOST_LOG_TRIVIAL(trace) << "Try to open Heidelberg Engineering Xml file as vol";
+			std::fstream stream(filepathConv(file), std::ios::binary | std::ios::in);
+			if(!stream.good())
+			{
+				BOOST_LOG_TRIVIAL(error) << "Can't open vol file " << filepathConv(file);
+				return false;
+			}
 
-		std::string xmlPath     = file.branch_path().generic_string();
-		// std::string xmlFilename = file.filename().generic_string();
+			// Load the XML file into the property tree. If reading fails
+			// (cannot open file, parse error), an exception is thrown.
+			bpt::xml_parser::read_xml(stream, pt);
 
-		// Create an empty property tree object
-		bpt::ptree pt;
 
+			boost::optional<bpt::ptree&> hedxNode = pt.get_child_optional("HEDX");
 
-		std::fstream stream(filepathConv(file), std::ios::binary | std::ios::in);
-		if(!stream.good())
-		{
-			BOOST_LOG_TRIVIAL(error) << "Can't open vol file " << filepathConv(file);
-			return false;
-		}
+			if(!hedxNode)
+				return false; // no Heidelberg Engineering Xml File
 
-		// Load the XML file into the property tree. If reading fails
-		// (cannot open file, parse error), an exception is thrown.
-		bpt::xml_parser::read_xml(stream, pt);
+			const char* patientNodeStr = "HEDX.BODY.Patient";
 
 
-		boost::optional<bpt::ptree&> hedxNode = pt.get_child_optional("HEDX");
+			bpt::ptree& patientNode = pt.get_child(patientNodeStr);
 
-		if(!hedxNode)
-			return false; // no Heidelberg Engineering Xml File
+			
+			boost::optional<bpt::ptree&> patUIDNode = patientNode.get_child_optional("PatientUIDList.PatientUID.UID");
 
-		const char* patientNodeStr = "HEDX.BODY.Patient";
+			std::string lastName       = patientNode.get_child("LastName"  ).get_value<std::string>(std::string());
+			std::string firstNames     = patientNode.get_child("FirstNames").get_value<std::string>(std::string());
+			std::string patientLongID  = patientNode.get_child("PatientID" ).get_value<std::string>(std::string());
+			std::string sex            = patientNode.get_child("Sex"       ).get_value<std::string>(std::string());
+			int         patientID      = patientNode.get_child("ID"        ).get_value<int>(0);
 
+			boost::optional<bpt::ptree&> patientBirthdateNode = patientNode.get_child_optional("Birthdate.Date");
+			// std::cout << xmlFilename << ": " << lastName << ", " << firstNames << std::endl;
 
-		bpt::ptree& patientNode = pt.get_child(patientNodeStr);
+			Patient& pat = oct.getPatient(patientID);
+			pat.setForename(firstNames   );
+			pat.setSurname (lastName     );
+			pat.setId      (patientLongID);
+			if(patUIDNode)
+				pat.setPatientUID(patUIDNode->get_value<std::string>(""));
+			if(patientBirthdateNode)
+				pat.setBirthdate(readDate(*patientBirthdateNode));
 
-		
-		boost::optional<bpt::ptree&> patUIDNode = patientNode.get_child_optional("PatientUIDList.PatientUID.UID");
+			if(sex == "F")
+				pat.setSex(Patient::Sex::Female);
+			else if(sex == "M")
+				pat.setSex(Patient::Sex::Male  );
 
-		std::string lastName       = patientNode.get_child("LastName"  ).get_value<std::string>(std::string());
-		std::string firstNames     = patientNode.get_child("FirstNames").get_value<std::string>(std::string());
-		std::string patientLongID  = patientNode.get_child("PatientID" ).get_value<std::string>(std::string());
-		std::string sex            = patientNode.get_child("Sex"       ).get_value<std::string>(std::string());
-		int         patientID      = patientNode.get_child("ID"        ).get_value<int>(0);
+			bpt::ptree& studyNode = patientNode.get_child("Study");
+			int         studyID   = studyNode  .get_child("ID"   ).get_value<int>(0);
 
-		boost::optional<bpt::ptree&> patientBirthdateNode = patientNode.get_child_optional("Birthdate.Date");
-		// std::cout << xmlFilename << ": " << lastName << ", " << firstNames << std::endl;
+			Study& study = pat.getStudy(studyID);
 
-		Patient& pat = oct.getPatient(patientID);
-		pat.setForename(firstNames   );
-		pat.setSurname (lastName     );
-		pat.setId      (patientLongID);
-		if(patUIDNode)
-			pat.setPatientUID(patUIDNode->get_value<std::string>(""));
-		if(patientBirthdateNode)
-			pat.setBirthdate(readDate(*patientBirthdateNode));
+			fillStudy(studyNode, study);
 
-		if(sex == "F")
-			pat.setSex(Patient::Sex::Female);
-		else if(sex == "M")
-			pat.setSex(Patient::Sex::Male  );
+			for(const std::pair<const std::string, bpt::ptree>& seriesStudyPair : studyNode)
+			{
+				if(seriesStudyPair.first != "Series")
+					continue;
 
-		bpt::ptree& studyNode = patientNode.get_child("Study");
-		int         studyID   = studyNode  .get_child("ID"   ).get_value<int>(0);
+				const bpt::ptree& seriesStudyNode = seriesStudyPair.second;
 
-		Study& study = pat.getStudy(studyID);
+				int seriesID = seriesStudyNode.get_child("ID").get_value<int>(0);
+				Series& series = study.getSeries(seriesID);
+				
+				fillSeries(seriesStudyNode, series);
 
-		fillStudy(studyNode, study);
+				const std::size_t numberOfSeriesNodes = seriesStudyNode.size();
+				      std::size_t actSeriesNodeNum    = 0;
+				      std::size_t numOctImages        = 0;
+				for(const std::pair<const std::string, bpt::ptree>& imageNode : seriesStudyNode)
+				{
+					++actSeriesNodeNum;
+					if(imageNode.first != "Image")
+						continue;
 
-		for(const std::pair<const std::string, bpt::ptree>& seriesStudyPair : studyNode)
-		{
-			if(seriesStudyPair.first != "Series")
-				continue;
+					if(callback)
+					{
+						if(!callback->callback(static_cast<double>(actSeriesNodeNum)/static_cast<double>(numberOfSeriesNodes)))
+							break;
+					}
 
-			const bpt::ptree& seriesStudyNode = seriesStudyPair.second;
+					boost::optional<const bpt::ptree&> type = imageNode.second.get_child_optional("ImageType.Type");
 
-			int seriesID = seriesStudyNode.get_child("ID").get_value<int>(0);
-			Series& series = study.getSeries(seriesID);
-			
-			fillSeries(seriesStudyNode, series);
+					if(!type)
+					{
+						std::cerr << __FILE__ << ":" << __LINE__ << ": image type not found\n";
+						continue;
+					}
 
-			const std::size_t numberOfSeriesNodes = seriesStudyNode.size();
-			      std::size_t actSeriesNodeNum    = 0;
-			for(const std::pair<const std::string, bpt::ptree>& imageNode : seriesStudyNode)
-			{
-				++actSeriesNodeNum;
-				if(imageNode.first != "Image")
-					continue;
+					std::string typeStr = type.get().get_value<std::string>();
 
-				if(callback)
-				{
-					if(!callback->callback(static_cast<double>(actSeriesNodeNum)/static_cast<double>(numberOfSeriesNodes)))
-						break;
-				}
+					if(typeStr == "LOCALIZER")
+					{
+						if(!probe)
+							fillSLOImage(imageNode.second, series, xmlPath);
+						fillSeriesLocalizer(imageNode.second, series);
+					}
+
+					if(typeStr == "OCT")
+					{
+						++numOctImages;
+						if(!probe && op.readBScans)
+							fillBScann(imageNode.second, studyNode, series, xmlPath);
+					}
 
-				boost::optional<const bpt::ptree&> type = imageNode.second.get_child_optional("ImageType.Type");
 
-				if(!type)
-				{
-					std::cerr << __FILE__ << ":" << __LINE__ << ": image type not found\n";
-					continue;
 				}
 
-				std::string typeStr = type.get().get_value<std::string>();
+				if(probe)
+					probe->addSeries(pat, study, series).bscanCount = numOctImages;
+			}
+			return true;
+		}
 
-				if(typeStr == "LOCALIZER")
-				{
-					fillSLOImage(imageNode.second, series, xmlPath);
-					fillSeriesLocalizer(imageNode.second, series);
-				}
+	}
 
-				if(typeStr == "OCT" && op.readBScans)
-					fillBScann(imageNode.second, studyNode, series, xmlPath);
 
 
-			}
-		}
-		return true;
+	HeXmlRead::HeXmlRead()
+	: OctFileReader(OctExtension(".xml", "Heidelberg Engineering Xml File"))
+	{
+	}
+
+	bool HeXmlRead::readFile(FileReader& filereader, OCT& oct, const FileReadOptions& op, CppFW::Callback* callback)
+	{
+		return readHeXml(filereader.getFilepath(), oct, op, callback, nullptr);
+	}
+
+	bool HeXmlRead::probeFile(FileReader& filereader, FileProbe& probe)
+	{
+		OCT oct;
+		return readHeXml(filereader.getFilepath(), oct, FileReadOptions(), nullptr, &probe);
 	}
 
 }
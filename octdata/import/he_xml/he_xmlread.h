@@ -11,12 +11,10 @@ namespace OctData
 	
 	class HeXmlRead : public OctFileReader
 	{
-		boost::filesystem::path xmlFilename;
-		boost::filesystem::path xmlPath;
-
 	public:
 		HeXmlRead();
 
 		virtual bool readFile(FileReader& filereader, OCT& oct, const FileReadOptions& op, CppFW::Callback* callback) override;
+		virtual bool probeFile(FileReader& filereader, FileProbe& probe) override;
 	};
 }
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+
+#include <boost/log/trivial.hpp>
+
+#include <datastruct/bscan.h>
+#include <datastruct/bscanimagecache.h>
+#include <filereader/filereader.h>
+#include <filereadoptions.h>
+
+
+namespace OctData
+{
+
+	// file and image cache shared by the lazy B-scans of one file (FileReadOptions::lazyBScans)
+	// the file is opened a second time, it stays open as long as one of the B-scans exists
+	class LazyBScanLoader
+	{
+		std::shared_ptr<FileReader>      filereader;
+		std::shared_ptr<BScanImageCache> cache;
+	public:
+		LazyBScanLoader(const FileReader& source, const FileReadOptions& op)
+		: filereader(std::make_shared<FileReader>(source.getFilepath(), op))
+		, cache     (std::make_shared<BScanImageCache>(static_cast<std::size_t>(std::max(op.lazyCacheSizeMB, 1))*1024*1024))
+		{
+			if(!filereader->openFile(true))
+			{
+				BOOST_LOG_TRIVIAL(error) << "Can't open " << source.getFilepath().generic_string() << " for lazy loading";
+				filereader.reset();
+			}
+		}
+
+		static bool useLazyLoading(const FileReadOptions& op)          { return op.lazyBScans && !op.holdRawData; }
+
+		bool isOpen()                                            const { return filereader != nullptr; }
+
+		// decode: bool(FileReader&, cv::Mat& image), called on first access of the image
+		template<typename Decoder>
+		BScan* createBScan(Decoder decode, int width, int height, const BScan::Data& data) const
+		{
+			std::shared_ptr<FileReader> reader = filereader;
+			return new BScan([reader, decode](cv::Mat& image) mutable { return decode(*reader, image); }, width, height, data, cache);
+		}
+	};
+
+}
@@ -9,6 +9,7 @@
 #include <ostream>
 #include <fstream>
 #include <iomanip>
+#include <functional>
 
 #include <opencv2/opencv.hpp>
 
@@ -22,6 +23,7 @@
 #include <boost/lexical_cast.hpp>
 
 #include<filereader/filereader.h>
+#include"../lazybscanloader.h"
 
 namespace bfs = boost::filesystem;
 
@@ -74,6 +76,22 @@ namespace
 	}
 
 
+	// decode FRAMESAMPLES at pos (lazy B-scans)
+	template<typename T>
+	bool readLazyFrameSamples(OctData::FileReader& filereader, std::size_t pos, cv::Mat& image, std::size_t sizeX, std::size_t sizeY)
+	{
+		uint32_t datalength;
+		filereader.seekg(pos);
+		filereader.readFStream(&datalength);
+
+		image = cv::Mat(static_cast<int>(sizeX), static_cast<int>(sizeY), cv::DataType<T>::type, cv::Scalar(0));
+		const std::size_t num = sizeX*sizeY;
+		filereader.readFStream(image.ptr<T>(), std::min<std::size_t>(num, datalength/sizeof(T)));
+
+		return filereader.good();
+	}
+
+
 	std::string readHeaderString(std::istream& stream)
 	{
 		uint32_t length = readDatafieldLength(stream);
@@ -291,8 +309,47 @@ namespace
 		OctData::Series& series;
 		const DictFrameHeader& dictFrameHeader;
 		const OctData::FileReadOptions& op;
+		const OctData::LazyBScanLoader* lazyLoader;
+
+		bool createLazyBScan(std::istream& stream, std::size_t& readedBytes)
+		{
+			const std::size_t pos        = stream.tellg();
+			const std::size_t linecount  = dictFrameHeader.getLinecount ();
+			const std::size_t linelength = dictFrameHeader.getLinelength();
+
+			std::function<bool(OctData::FileReader&, cv::Mat&)> decode;
+			switch(dictFrameHeader.getSampleformat())
+			{
+				case 1:
+					decode = [pos, linecount, linelength](OctData::FileReader& reader, cv::Mat& image)
+					{
+						cv::Mat viewImage;
+						const bool ok = readLazyFrameSamples<uint8_t>(reader, pos, viewImage, linecount, linelength);
+						image = viewImage.t();
+						return ok;
+					};
+					break;
+				case 2:
+					decode = [pos, linecount, linelength](OctData::FileReader& reader, cv::Mat& image)
+					{
+						cv::Mat rawImage, viewImage;
+						const bool ok = readLazyFrameSamples<uint16_t>(reader, pos, rawImage, linecount, linelength);
+						rawImage.convertTo(viewImage, CV_8U, 1/255., 0);
+						image = viewImage.t();
+						return ok;
+					};
+					break;
+				default:
+					return false;
+			}
+
+			readedBytes += readRaw(stream);
+			series.takeBScan(lazyLoader->createBScan(decode, static_cast<int>(linecount), static_cast<int>(linelength), bscanData));
+			return true;
+		}
 	public:
-		DictFrameData(OctData::Series& series, const DictFrameHeader& dictFrameHeader, const OctData::FileReadOptions& op) : series(series), dictFrameHeader(dictFrameHeader), op(op) {}
+		DictFrameData(OctData::Series& series, const DictFrameHeader& dictFrameHeader, const OctData::FileReadOptions& op, const OctData::LazyBScanLoader* lazyLoader)
+		: series(series), dictFrameHeader(dictFrameHeader), op(op), lazyLoader(lazyLoader) {}
 
 		void handelDictEntry(std::istream& stream, const std::string& name, std::size_t& readedBytes)
 		{
@@ -319,6 +376,9 @@ namespace
 			}
  			else if(name == "FRAMESAMPLES"  )
 			{
+				if(lazyLoader && createLazyBScan(stream, readedBytes))
+					return;
+
 				cv::Mat rawImage, viewImage;
 
 				switch(dictFrameHeader.getSampleformat())
@@ -364,8 +424,10 @@ namespace
 		const OctData::FileReadOptions& op;
 		CppFW::CallbackStepper& callbackStepper;
 		DictFrameHeader dictFrameHeader;
+		const OctData::LazyBScanLoader* lazyLoader;
 	public:
-		MainDict(OctData::Series& series, const OctData::FileReadOptions& op, CppFW::CallbackStepper& callbackStepper) : series(series), op(op), callbackStepper(callbackStepper) {}
+		MainDict(OctData::Series& series, const OctData::FileReadOptions& op, CppFW::CallbackStepper& callbackStepper, const OctData::LazyBScanLoader* lazyLoader)
+		: series(series), op(op), callbackStepper(callbackStepper), lazyLoader(lazyLoader) {}
 
 		void handelDictEntry(std::istream& stream, const std::string& name, std::size_t& readedBytes)
 		{
@@ -377,7 +439,7 @@ namespace
 // 			std::cout << "Dict: \t" << name << std::endl;
 			if(name == "FRAMEDATA")
 			{
-				DictFrameData dictFrameData(series, dictFrameHeader, op);
+				DictFrameData dictFrameData(series, dictFrameHeader, op, lazyLoader);
 				readedBytes += readDict(stream, dictFrameData, dictLength);
 			}
 			else if(name == "FRAMEHEADER")
@@ -406,6 +468,7 @@ namespace OctData
 	OctFileFormatRead::OctFileFormatRead()
 	: OctFileReader(OctExtension(".OCT", "Bioptigen Oct file"))
 	{
+		addSignature(0, std::string("\xa5\xa7\x7d\x0c", 4));
 	}
 
 	bool OctFileFormatRead::readFile(FileReader& filereader, OCT& oct, const FileReadOptions& op, CppFW::Callback* callback)
@@ -419,9 +482,6 @@ namespace OctData
 //     BOOST_LOG_TRIVIAL(error) << "An error severity message";
 //     BOOST_LOG_TRIVIAL(fatal) << "A fatal severity message";
 
-		if(file.extension() != ".OCT")
-			return false;
-
 		BOOST_LOG_TRIVIAL(trace) << "Try to open OCT file as Bioptigen oct file";
 
 		boost::system::error_code ec;
@@ -468,7 +528,15 @@ namespace OctData
 
 
 
-		MainDict mainDict(series, op, callbackStepper);
+		std::unique_ptr<LazyBScanLoader> lazyLoader;
+		if(LazyBScanLoader::useLazyLoading(op))
+		{
+			lazyLoader.reset(new LazyBScanLoader(filereader, op));
+			if(!lazyLoader->isOpen())
+				lazyLoader.reset();
+		}
+
+		MainDict mainDict(series, op, callbackStepper, lazyLoader.get());
 
 		stream.seekg(0, std::ios_base::end);
 		std::size_t fielsize = stream.tellg();
@@ -11,6 +11,7 @@ namespace OctData
 		OctFileFormatRead();
 
 	    virtual bool readFile(FileReader& filereader, OCT& oct, const FileReadOptions& op, CppFW::Callback* callback) override;
+	    virtual bool supportsLazyBScans() const override { return true; }
 	};
 }
 
@@ -35,6 +35,11 @@ namespace OctData
 
 	}
 
+	bool OctFileReader::probeFile(FileReader& /*filereader*/, FileProbe& /*probe*/)
+	{
+		return false;
+	}
+
 	void OctFileReader::registerReaders(OctFileRead& fileRead)
 	{
 #ifdef HE_VOL_SUPPORT
@@ -2,6 +2,9 @@
 
 #include "../octextension.h"
 
+#include <string>
+#include <vector>
+
 namespace CppFW { class Callback; }
 
 namespace OctData
@@ -10,10 +13,28 @@ namespace OctData
 	class OctFileRead;
 	class OCT;
 	class FileReader;
+	class FileProbe;
+
+	// magic bytes at a fixed offset of the file
+	struct FileSignature
+	{
+		std::size_t offset;
+		std::string magic;
+
+		bool matchWithHeader(const std::string& header) const
+		{
+			return header.size() >= offset + magic.size() && header.compare(offset, magic.size(), magic) == 0;
+		}
+	};
+	typedef std::vector<FileSignature> FileSignatureList;
 
 	class OctFileReader
 	{
 		OctExtensionsList extList;
+		FileSignatureList signatures;
+
+	protected:
+		void addSignature(std::size_t offset, const std::string& magic) { signatures.push_back(FileSignature{offset, magic}); }
 
 	public:
 		OctFileReader();
@@ -22,7 +43,13 @@ namespace OctData
 
 		virtual ~OctFileReader();
 		virtual bool readFile(FileReader& filereader, OCT& oct, const FileReadOptions& op, CppFW::Callback* callback) = 0;
+		// summary from the headers without reading pixel data, false for formats without a header probe (the default)
+		virtual bool probeFile(FileReader& filereader, FileProbe& probe);
+		// the reader honours FileReadOptions::lazyBScans
+		virtual bool supportsLazyBScans()        const { return false; }
 		const OctExtensionsList& getExtentsions() const { return extList; }
+		// readers with signatures are only tried on files with matching header or extension
+		const FileSignatureList& getSignatures()  const { return signatures; }
 
 		static void registerReaders(OctFileRead& fileRead);
 	};
@@ -0,0 +1,57 @@
+#include "threadpool.h"
+
+
+namespace OctData
+{
+
+	ThreadPool::ThreadPool(std::size_t numThreads)
+	{
+		if(numThreads < 2)
+			return;
+
+		workers.reserve(numThreads);
+		for(std::size_t i = 0; i < numThreads; ++i)
+			workers.emplace_back(&ThreadPool::workerLoop, this);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+			tasks.clear();
+		}
+		condition.notify_all();
+
+		for(std::thread& worker : workers)
+			worker.join();
+	}
+
+	std::size_t ThreadPool::resolveNumThreads(int numThreads)
+	{
+		if(numThreads > 0)
+			return static_cast<std::size_t>(numThreads);
+
+		const unsigned hardwareThreads = std::thread::hardware_concurrency();
+		return hardwareThreads > 0 ? hardwareThreads : 1;
+	}
+
+	void ThreadPool::workerLoop()
+	{
+		for(;;)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait(lock, [this]() { return stop || !tasks.empty(); });
+				if(stop)
+					return;
+
+				task = std::move(tasks.front());
+				tasks.pop_front();
+			}
+			task();
+		}
+	}
+
+}
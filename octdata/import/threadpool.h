@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace OctData
+{
+
+	// fixed size thread pool for the decoding work of the readers
+	// with less than two threads the tasks are executed directly in submit
+	// the destructor discards the tasks not started yet and waits for the running ones
+	class ThreadPool
+	{
+		std::vector<std::thread>          workers;
+		std::deque<std::function<void()>> tasks;
+		std::mutex                        mutex;
+		std::condition_variable           condition;
+		bool                              stop = false;
+
+		void workerLoop();
+	public:
+		explicit ThreadPool(std::size_t numThreads);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&)            = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		std::size_t numThreads()                                 const { return workers.empty() ? 1 : workers.size(); }
+
+		// numThreads option of FileReadOptions: <= 0 means one thread per hardware thread
+		static std::size_t resolveNumThreads(int numThreads);
+
+		// calls func(begin, end) for chunks of [0, size) with at least minChunk elements in parallel, returns after all chunks
+		template<typename F>
+		static void parallelFor(std::size_t size, std::size_t minChunk, F func)
+		{
+			if(size == 0)
+				return;
+
+			const std::size_t numTasks  = std::min(resolveNumThreads(0), (size + minChunk - 1)/minChunk);
+			const std::size_t chunkSize = (size + numTasks - 1)/numTasks;
+
+			ThreadPool pool(numTasks);
+			std::vector<std::future<void>> results;
+			for(std::size_t begin = 0; begin < size; begin += chunkSize)
+			{
+				const std::size_t end = std::min(begin + chunkSize, size);
+				results.push_back(pool.submit([&func, begin, end]() { func(begin, end); }));
+			}
+			for(std::future<void>& result : results)
+				result.get();
+		}
+
+		// like parallelFor but on the threads of this pool, the first chunk runs in the calling thread
+		// the queued chunks reference func, so all chunks are finished before an exception is rethrown
+		template<typename F>
+		void runChunks(std::size_t size, std::size_t minChunk, F func)
+		{
+			if(size == 0)
+				return;
+
+			const std::size_t numChunks = std::max(std::min(numThreads(), size/minChunk), static_cast<std::size_t>(1));
+			const std::size_t chunkSize = (size + numChunks - 1)/numChunks;
+
+			std::vector<std::future<void>> results;
+			std::exception_ptr error;
+			try
+			{
+				for(std::size_t begin = chunkSize; begin < size; begin += chunkSize)
+				{
+					const std::size_t end = std::min(begin + chunkSize, size);
+					results.push_back(submit([&func, begin, end]() { func(begin, end); }));
+				}
+				func(0, std::min(chunkSize, size));
+			}
+			catch(...)
+			{
+				error = std::current_exception();
+			}
+
+			for(std::future<void>& result : results)
+				result.wait();
+			if(error)
+				std::rethrow_exception(error);
+			for(std::future<void>& result : results)
+				result.get();
+		}
+
+		template<typename F>
+		std::future<typename std::result_of<F()>::type> submit(F task)
+		{
+			typedef typename std::result_of<F()>::type ResultType;
+
+			std::shared_ptr<std::packaged_task<ResultType()>> packagedTask = std::make_shared<std::packaged_task<ResultType()>>(std::move(task));
+			std::future<ResultType> result = packagedTask->get_future();
+
+			if(workers.empty())
+			{
+				(*packagedTask)();
+				return result;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				tasks.emplace_back([packagedTask]() { (*packagedTask)(); });
+			}
+			condition.notify_one();
+			return result;
+		}
+	};
+
+}
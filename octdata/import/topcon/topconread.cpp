@@ -4,8 +4,12 @@
 #include<ostream>
 #include<fstream>
 #include<iomanip>
+#include<algorithm>
 #include<array>
 #include<cmath>
+#include<future>
+#include<memory>
+#include<vector>
 
 #include <boost/log/trivial.hpp>
 #include <boost/lexical_cast.hpp>
@@ -25,6 +29,7 @@
 
 
 #include "../platform_helper.h"
+#include "../threadpool.h"
 #include "readjpeg2k.h"
 #include "topcondata.h"
 
@@ -74,21 +79,43 @@ namespace
 		return dest;
 	}
 
-	cv::Mat readAndEncodeJPEG2kData(std::istream& stream, uint32_t size)
+	cv::Mat decodeJPEG2kData(const std::vector<char>& encodedData)
 	{
-		std::unique_ptr<char> encodedData(new char[size]);
-		stream.read(encodedData.get(), size);
-
 		cv::Mat image;
 		ReadJPEG2K reader;
-		reader.openJpeg(encodedData.get(), size);
+		reader.openJpeg(encodedData.data(), encodedData.size());
 		reader.getImage(image, false);
 
 		return image;
 	}
 
+	cv::Mat readAndEncodeJPEG2kData(std::istream& stream, uint32_t size)
+	{
+		std::vector<char> encodedData(size);
+		stream.read(encodedData.data(), size);
+
+		return decodeJPEG2kData(encodedData);
+	}
+
+	cv::Mat decodeBScanFrame(const std::vector<char>& encodedData)
+	{
+		cv::Mat image = decodeJPEG2kData(encodedData);
+		image.convertTo(image, cv::DataType<uint8_t>::type, 2, -128);
+		return image;
+	}
+
+
+	// end of the data in the stream, limited by the end of the stream (the chunk size is not trusted)
+	std::streamoff dataEnd(std::istream& stream, std::streamoff chunkEnd)
+	{
+		const std::streamoff pos = stream.tellg();
+		stream.seekg(0, std::ios_base::end);
+		const std::streamoff streamEnd = stream.tellg();
+		stream.seekg(pos);
+		return std::min(chunkEnd, streamEnd);
+	}
 
-	void readImgJpeg(std::istream& stream, TopconData& data, CppFW::Callback* callback, const OctData::FileReadOptions& op)
+	void readImgJpeg(std::istream& stream, TopconData& data, CppFW::Callback* callback, const OctData::FileReadOptions& op, std::streamoff chunkEnd)
 	{
 		if(!op.readBScans)
 			return;
@@ -134,21 +161,53 @@ namespace
 // 				break;
 		}
 
+		// read the compressed frames first, the frames are independent and decoded in parallel (one codec per task)
+		// frames and size are not trusted, nothing is allocated beyond the data left in the chunk
+		const std::streamoff end = dataEnd(stream, chunkEnd);
+		std::vector<std::shared_ptr<std::vector<char>>> encodedFrames;
 		for(uint32_t frame = 0; frame < frames; ++frame)
 		{
 			if(callback)
 			{
-				if(!callback->callback(static_cast<double>(frame)/static_cast<double>(frames)))
-					break;
+				if(!callback->callback(static_cast<double>(frame)/static_cast<double>(frames)*0.5))
+					return;
 			}
 
 			const uint32_t size = readFStream<uint32_t>(stream);
-			cv::Mat image = readAndEncodeJPEG2kData(stream, size);
+			const std::streamoff pos = stream.tellg();
+			if(!stream.good() || pos < 0 || static_cast<std::streamoff>(size) > end - pos)
+			{
+				BOOST_LOG_TRIVIAL(error) << "frame " << frame << " of @IMG_JPEG chunk exceeds the chunk (" << size << " bytes)";
+				break;
+			}
+
+			std::shared_ptr<std::vector<char>> encodedData = std::make_shared<std::vector<char>>(size);
+			stream.read(encodedData->data(), size);
+			if(!stream.good())
+			{
+				BOOST_LOG_TRIVIAL(error) << "unexpected end of @IMG_JPEG chunk in frame " << frame;
+				break;
+			}
+			encodedFrames.push_back(encodedData);
+		}
 
-			image.convertTo(image, cv::DataType<uint8_t>::type, 2, -128);
+		OctData::ThreadPool threadPool(OctData::ThreadPool::resolveNumThreads(op.numThreads));
+		std::vector<std::future<cv::Mat>> decodedFrames;
+		decodedFrames.reserve(encodedFrames.size());
+		for(const std::shared_ptr<std::vector<char>>& encodedData : encodedFrames)
+			decodedFrames.push_back(threadPool.submit([encodedData]() { return decodeBScanFrame(*encodedData); }));
+
+		// all frames are in bscanList before the next chunk (@CONTOUR_INFO) is read
+		for(std::size_t frame = 0; frame < decodedFrames.size(); ++frame)
+		{
+			if(callback)
+			{
+				if(!callback->callback(0.5 + static_cast<double>(frame)/static_cast<double>(frames)*0.5))
+					break;
+			}
 
 			TopconData::BScanPair pair;
-			pair.image = image;
+			pair.image = decodedFrames[frame].get();
 			pair.data.bscanType = bscanType;
 			data.bscanList.push_back(pair);
 
@@ -483,6 +542,7 @@ namespace OctData
 	TopconFileFormatRead::TopconFileFormatRead()
 	: OctFileReader(OctExtension(".fda", "Topcon"))
 	{
+		addSignature(0, "FOCT");
 	}
 
 	bool TopconFileFormatRead::readFile(FileReader& filereader, OCT& oct, const FileReadOptions& op, CppFW::Callback* callback)
@@ -496,9 +556,6 @@ namespace OctData
 //     BOOST_LOG_TRIVIAL(error) << "An error severity message";
 //     BOOST_LOG_TRIVIAL(fatal) << "A fatal severity message";
 
-		if(file.extension() != ".fda")
-			return false;
-
 		BOOST_LOG_TRIVIAL(trace) << "Try to open OCT file as topcon file";
 
 
@@ -558,7 +615,7 @@ namespace OctData
 			if(chunkName == "@IMG_TRC_02")
 				readImgSlo(stream, data, SLOType::TRC);
 			else if(chunkName == "@IMG_JPEG")
-				readImgJpeg(stream, data, callback, op);
+				readImgJpeg(stream, data, callback, op, chunkBegin + chunkSize);
 			else if(chunkName == "@PATIENT_INFO_02")
 				readPatientInfo0203(stream, data, op, false);
 			else if(chunkName == "@PATIENT_INFO_03")
@@ -280,6 +280,7 @@ namespace OctData
 	XOctRead::XOctRead()
 	: OctFileReader(OctExtension(".xoct", "XOct format"))
 	{
+		addSignature(0, std::string("PK\x03\x04", 4)); // zip container, xoct.xml is checked by the extension
 	}
 
 	bool OctData::XOctRead::readFile(OctData::FileReader& filereader, OctData::OCT& oct, const OctData::FileReadOptions& op, CppFW::Callback* callback)
@@ -27,13 +27,14 @@ namespace OctData
 {
 	class OctExtension
 	{
+	public:
 		static std::string toLower(const std::string& str)
 		{
 			std::string lowerCaseStr = str;
 			std::transform(lowerCaseStr.begin(), lowerCaseStr.end(), lowerCaseStr.begin(), ::tolower);
 			return lowerCaseStr;
 		}
-	public:
+
 		typedef std::vector<std::string> ExtList;
 		
 		OctExtension() = default;
@@ -70,21 +71,27 @@ namespace OctData
 
 		bool matchWithFile(const std::string& filename) const
 		{
-			const std::size_t fileLength = filename.length();
-			std::string lowerCaseName = toLower(filename);
+			return matchWithLowerCaseFile(toLower(filename));
+		}
 
+		// filename must be converted with toLower
+		bool matchWithLowerCaseFile(const std::string& lowerCaseName) const
+		{
 			for(const std::string& str : extensionsLowerCase)
-			{
-				const std::size_t extLength = str.length();
-				if(fileLength > extLength)
-				{
-					if(str == lowerCaseName.substr(fileLength-extLength, extLength))
-						return true;
-				}
-			}
+				if(matchSuffix(lowerCaseName, str))
+					return true;
 			return false;
 		}
 
+		static bool matchSuffix(const std::string& lowerCaseName, const std::string& lowerCaseExt)
+		{
+			const std::size_t fileLength = lowerCaseName.length();
+			const std::size_t extLength  = lowerCaseExt.length();
+			return fileLength > extLength && lowerCaseName.compare(fileLength-extLength, extLength, lowerCaseExt) == 0;
+		}
+
+		const ExtList& getExtensionsLowerCase()                  const { return extensionsLowerCase; }
+
 
 		ExtList extensions;
 		std::string name;
@@ -102,8 +109,9 @@ namespace OctData
 
 		bool matchWithFile(const std::string& filename) const
 		{
+			const std::string lowerCaseName = OctExtension::toLower(filename);
 			for(const OctExtension& ext : *this)
-				if(ext.matchWithFile(filename))
+				if(ext.matchWithLowerCaseFile(lowerCaseName))
 					return true;
 			return false;
 		}
@@ -21,6 +21,7 @@
 #include "import/octfilereader.h"
 #include "filereadoptions.h"
 #include "filewriteoptions.h"
+#include "fileprobe.h"
 
 #include<opencv/cv.hpp>
 
@@ -34,12 +35,135 @@ namespace bfs = boost::filesystem;
 #include<filereader/filereader.h>
 
 #include "import/platform_helper.h"
+#include "import/threadpool.h"
 #include<export/cirrus_raw/cirrusrawexport.h>
 #include<export/xoct/xoctwrite.h>
 #include<export/cvbin/cvbinoctwrite.h>
 
+#include<algorithm>
+#include<atomic>
+#include<condition_variable>
+#include<exception>
+#include<mutex>
+
 namespace OctData
 {
+	namespace
+	{
+		void packSeries(OCT& oct, const FileReadOptions& op)
+		{
+			for(const OCT::SubstructurePair& patientPair : oct)
+				for(const Patient::SubstructurePair& studyPair : *patientPair.second)
+					for(const Study::SubstructurePair& seriesPair : *studyPair.second)
+					{
+						Series& series = *seriesPair.second;
+						if(op.packBScans)
+							series.packBScanImages();
+
+						switch(op.segmentationStorage)
+						{
+							case FileReadOptions::SegmentationStorage::float32:
+								series.packSegmentation(SegmentationStore::Precision::Float);
+								break;
+							case FileReadOptions::SegmentationStorage::int16:
+								series.packSegmentation(SegmentationStore::Precision::Int16);
+								break;
+							case FileReadOptions::SegmentationStorage::bscan:
+								break;
+						}
+					}
+		}
+
+		// blocks openFiles workers while the files in progress exceed the memory budget
+		// a file larger than the budget is admitted when nothing else is in progress
+		class MemoryBudget
+		{
+			const std::size_t       budget;
+			std::size_t             used     = 0;
+			bool                    canceled = false;
+			std::mutex              mutex;
+			std::condition_variable condition;
+		public:
+			explicit MemoryBudget(std::size_t budget) : budget(budget) {}
+
+			// false if the budget was canceled, nothing is reserved then
+			bool acquire(std::size_t size)
+			{
+				if(budget == 0)
+					return true;
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait(lock, [this, size]() { return canceled || used == 0 || used + size <= budget; });
+				if(canceled)
+					return false;
+				used += size;
+				return true;
+			}
+
+			void release(std::size_t size)
+			{
+				if(budget == 0)
+					return;
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					used -= size;
+				}
+				condition.notify_all();
+			}
+
+			// wakes up the waiting workers, further acquire calls fail
+			void cancel()
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					canceled = true;
+				}
+				condition.notify_all();
+			}
+		};
+
+		// memory reserved in a MemoryBudget, released by the destructor
+		class MemoryReservation
+		{
+			MemoryBudget&     budget;
+			const std::size_t size;
+			const bool        reserved;
+		public:
+			MemoryReservation(MemoryBudget& budget, std::size_t size) : budget(budget), size(size), reserved(budget.acquire(size)) {}
+			~MemoryReservation()                                       { if(reserved) budget.release(size); }
+
+			MemoryReservation(const MemoryReservation&)            = delete;
+			MemoryReservation& operator=(const MemoryReservation&) = delete;
+
+			bool isReserved()                                    const { return reserved; }
+		};
+
+		// decoded B-scan and SLO images from the file headers, 0 if the headers give no image sizes
+		std::size_t estimateMemory(const FileProbe& probe, const FileReadOptions& op)
+		{
+			const std::size_t rawBytes = op.rawStorage == FileReadOptions::RawStorage::float16 ? sizeof(uint16_t) : sizeof(float);
+			std::size_t bytesPerPixel = op.holdRawData ? 1 + rawBytes : 1;
+			if(op.deriveBScanImages)
+				bytesPerPixel = rawBytes; // the derived images are limited by the cache
+
+			std::size_t bytes = 0;
+			for(const FileProbe::SeriesInfo& info : probe.series)
+			{
+				bytes += info.bscanCount*info.bscanWidth*info.bscanHeight*bytesPerPixel;
+				bytes += info.sloWidth*info.sloHeight;
+			}
+			return bytes;
+		}
+
+		std::size_t fileSizeOnDisk(const bfs::path& file)
+		{
+			boost::system::error_code ec;
+			const boost::uintmax_t size = bfs::file_size(file, ec);
+			if(ec)
+				return 0;
+			return static_cast<std::size_t>(size);
+		}
+	}
+
 	OctFileRead::OctFileRead()
 	{
 		BOOST_LOG_TRIVIAL(info) << "OctData: Build Type      : " << BuildConstants::buildTyp;
@@ -78,6 +202,18 @@ namespace OctData
 
 
 
+	std::size_t OctFileRead::openFiles(const std::vector<boost::filesystem::path>& files, const FileReadOptions& op, const FileOpenedCallback& fileOpened, int concurrency, std::size_t memoryBudgetMB)
+	{
+		return getInstance().openFilesPrivat(files, op, fileOpened, concurrency, memoryBudgetMB);
+	}
+
+
+
+	std::shared_ptr<const OCT> OctFileRead::openSnapshot(const bfs::path& filename, const FileReadOptions& op, CppFW::Callback* callback)
+	{
+		return OCT::makeSnapshot(getInstance().openFilePrivat(filename, op, callback));
+	}
+
 	OCT OctFileRead::openFilePrivat(const std::string& filename, const FileReadOptions& op, CppFW::Callback* callback)
 	{
 		bfs::path file(filenameConv(filename));
@@ -86,24 +222,52 @@ namespace OctData
 
 
 
-	bool OctFileRead::openFileFromExt(OCT& oct, FileReader& filereader, const FileReadOptions& op, CppFW::Callback* callback)
+	std::vector<OctFileReader*> OctFileRead::readersForExtension(const std::string& filename) const
+	{
+		const std::string lowerCaseName = OctExtension::toLower(filename);
+
+		std::vector<OctFileReader*> readers;
+		for(const std::pair<std::string, OctFileReader*>& suffix : suffixTable)
+			if(OctExtension::matchSuffix(lowerCaseName, suffix.first)
+			&& std::find(readers.begin(), readers.end(), suffix.second) == readers.end())
+				readers.push_back(suffix.second);
+		return readers;
+	}
+
+	// readers with a signature matching the file header, followed by the readers without signature
+	std::vector<OctFileReader*> OctFileRead::readersForHeader(FileReader& filereader) const
 	{
-		std::string filename = filereader.getFilepath().generic_string();
+		const std::string header = filereader.readHeader(signatureHeaderSize);
+
+		std::vector<OctFileReader*> readers;
+		for(OctFileReader* reader : fileReaders)
+			for(const FileSignature& signature : reader->getSignatures())
+				if(signature.matchWithHeader(header))
+				{
+					readers.push_back(reader);
+					break;
+				}
+
 		for(OctFileReader* reader : fileReaders)
+			if(reader->getSignatures().empty())
+				readers.push_back(reader);
+		return readers;
+	}
+
+	bool OctFileRead::openFileFromExt(OCT& oct, FileReader& filereader, const FileReadOptions& op, CppFW::Callback* callback)
+	{
+		for(OctFileReader* reader : readersForExtension(filereader.getFilepath().generic_string()))
 		{
-			if(reader->getExtentsions().matchWithFile(filename))
-			{
-				if(reader->readFile(filereader, oct, op, callback))
-					return true;
-				oct.clear();
-			}
+			if(reader->readFile(filereader, oct, op, callback))
+				return true;
+			oct.clear();
 		}
 		return false;
 	}
 
 	bool OctFileRead::tryOpenFile(OCT& oct, FileReader& filereader, const FileReadOptions& op, CppFW::Callback* callback)
 	{
-		for(OctFileReader* reader : fileReaders)
+		for(OctFileReader* reader : readersForHeader(filereader))
 		{
 			if(reader->readFile(filereader, oct, op, callback))
 				return true;
@@ -114,20 +278,226 @@ namespace OctData
 
 	OCT OctFileRead::openFilePrivat(const boost::filesystem::path& file, const FileReadOptions& op, CppFW::Callback* callback)
 	{
-		FileReader filereader(file);
 		OctData::OCT oct;
 
-		if(bfs::exists(file))
+		if(!bfs::exists(file))
 		{
-			if(!openFileFromExt(oct, filereader, op, callback))
-				tryOpenFile(oct, filereader, op, callback);
-		}
-		else
 			BOOST_LOG_TRIVIAL(error) << "file " << file.generic_string() << " not exists";
+			return oct;
+		}
+
+		FileReadOptions fileOp = op;
+		if(!applyMemoryBudget(file, fileOp))
+			return oct;
+
+		FileReader filereader(file, fileOp);
+		if(!openFileFromExt(oct, filereader, fileOp, callback))
+			tryOpenFile(oct, filereader, fileOp, callback);
+
+		packSeries(oct, fileOp);
+
+		if(op.memoryBudgetMB > 0)
+		{
+			const std::size_t used   = oct.memoryUsage().total();
+			const std::size_t budget = static_cast<std::size_t>(op.memoryBudgetMB)*1024*1024;
+			if(used > budget)
+			{
+				BOOST_LOG_TRIVIAL(error) << "file " << file.generic_string() << " uses " << used/(1024*1024) << " MB, memory budget " << op.memoryBudgetMB << " MB";
+				if(op.memoryBudgetAction == FileReadOptions::MemoryBudgetAction::fail)
+					oct.clear();
+			}
+		}
 
 		return oct;
 	}
 
+	bool OctFileRead::applyMemoryBudget(const bfs::path& file, FileReadOptions& op)
+	{
+		if(op.memoryBudgetMB <= 0 || op.lazyBScans)
+			return true;
+
+		bool lazyReader = false;
+		const std::size_t budget    = static_cast<std::size_t>(op.memoryBudgetMB)*1024*1024;
+		const std::size_t estimated = estimateFileMemory(file, op, &lazyReader);
+		if(estimated == 0)
+		{
+			// no image sizes from the probe: the size on disk is no bound for compressed formats (fda, xoct, DICOM)
+			if(op.memoryBudgetAction == FileReadOptions::MemoryBudgetAction::fail)
+			{
+				BOOST_LOG_TRIVIAL(error) << "file " << file.generic_string() << ": memory unknown (no header probe), memory budget " << op.memoryBudgetMB << " MB";
+				return false;
+			}
+			BOOST_LOG_TRIVIAL(warning) << "file " << file.generic_string() << ": memory unknown (no header probe), checked after reading";
+			return true;
+		}
+		if(estimated <= budget)
+			return true;
+
+		if(op.memoryBudgetAction == FileReadOptions::MemoryBudgetAction::fail || !lazyReader)
+		{
+			BOOST_LOG_TRIVIAL(error) << "file " << file.generic_string() << " needs about " << estimated/(1024*1024) << " MB, memory budget " << op.memoryBudgetMB << " MB";
+			return false;
+		}
+
+		BOOST_LOG_TRIVIAL(warning) << "file " << file.generic_string() << " needs about " << estimated/(1024*1024) << " MB, read with lazy B-scans";
+		op.lazyBScans        = true;
+		op.holdRawData       = false;
+		op.deriveBScanImages = false;
+		op.lazyCacheSizeMB   = std::min(op.lazyCacheSizeMB, op.memoryBudgetMB);
+		return true;
+	}
+
+	std::size_t OctFileRead::estimateFileMemory(const bfs::path& file, const FileReadOptions& op, bool* lazyReader)
+	{
+		const OctFileReader* reader = nullptr;
+		const std::size_t estimated = estimateMemory(probePrivat(file, reader), op);
+		if(lazyReader)
+			*lazyReader = reader && reader->supportsLazyBScans();
+		return estimated;
+	}
+
+	std::size_t OctFileRead::openFilesPrivat(const std::vector<bfs::path>& files, const FileReadOptions& op, const FileOpenedCallback& fileOpened, int concurrency, std::size_t memoryBudgetMB)
+	{
+		const std::size_t numWorkers = std::min(ThreadPool::resolveNumThreads(concurrency), std::max(files.size(), static_cast<std::size_t>(1)));
+
+		// share the hardware threads between the files instead of oversubscribing them
+		FileReadOptions fileOp = op;
+		if(fileOp.numThreads <= 0)
+			fileOp.numThreads = static_cast<int>(std::max(ThreadPool::resolveNumThreads(0)/numWorkers, static_cast<std::size_t>(1)));
+
+		MemoryBudget             budget(memoryBudgetMB*1024*1024);
+		std::atomic<std::size_t> nextFile(0);
+		std::atomic<std::size_t> numRead (0);
+		std::atomic<bool>        stop    (false);
+		std::mutex               callbackMutex;
+		std::exception_ptr       error;
+
+		auto stopWorkers = [&]()
+		{
+			stop = true;
+			budget.cancel();
+		};
+
+		auto worker = [&]()
+		{
+			try
+			{
+				for(;;)
+				{
+					const std::size_t index = nextFile++;
+					if(index >= files.size() || stop)
+						return;
+
+					const bfs::path& file = files[index];
+					std::size_t reserve = 0;
+					if(memoryBudgetMB > 0)
+					{
+						reserve = estimateFileMemory(file, fileOp);
+						if(reserve == 0)
+							reserve = fileSizeOnDisk(file); // unknown estimate: the size on disk is only a lower bound
+					}
+					MemoryReservation reservation(budget, reserve);
+					if(!reservation.isReserved() || stop)
+						return;
+
+					OCT oct = openFilePrivat(file, fileOp, nullptr);
+					if(oct.size() > 0)
+						++numRead;
+
+					if(fileOpened)
+					{
+						std::lock_guard<std::mutex> lock(callbackMutex);
+						if(!stop && !fileOpened(file, oct))
+							stopWorkers();
+					}
+				}
+			}
+			catch(...)
+			{
+				{
+					std::lock_guard<std::mutex> lock(callbackMutex);
+					if(!error)
+						error = std::current_exception();
+				}
+				stopWorkers();
+			}
+		};
+
+		{
+			ThreadPool pool(numWorkers);
+			std::vector<std::future<void>> results;
+			results.reserve(numWorkers);
+			for(std::size_t i = 0; i < numWorkers; ++i)
+				results.push_back(pool.submit(worker));
+			for(std::future<void>& result : results)
+				result.get();
+		}
+
+		// the first exception of a worker, after all workers are finished
+		if(error)
+			std::rethrow_exception(error);
+
+		return numRead;
+	}
+
+	FileProbe OctFileRead::probe(const std::string& filename)
+	{
+		return getInstance().probePrivat(bfs::path(filenameConv(filename)));
+	}
+
+	FileProbe OctFileRead::probe(const boost::filesystem::path& filename)
+	{
+		return getInstance().probePrivat(filename);
+	}
+
+	bool OctFileRead::probeFileWithReader(OctFileReader& reader, FileReader& filereader, FileProbe& probe)
+	{
+		if(!reader.probeFile(filereader, probe))
+		{
+			probe.series.clear();
+			return false;
+		}
+
+		const OctExtensionsList& extList = reader.getExtentsions();
+		if(!extList.empty())
+			probe.format = extList.front().name;
+		return true;
+	}
+
+	FileProbe OctFileRead::probePrivat(const bfs::path& file)
+	{
+		const OctFileReader* reader = nullptr;
+		return probePrivat(file, reader);
+	}
+
+	FileProbe OctFileRead::probePrivat(const bfs::path& file, const OctFileReader*& probedBy)
+	{
+		FileProbe probe;
+		if(!bfs::exists(file))
+		{
+			BOOST_LOG_TRIVIAL(error) << "file " << file.generic_string() << " not exists";
+			return probe;
+		}
+
+		FileReader filereader(file, FileReadOptions());
+
+		for(OctFileReader* reader : readersForExtension(file.generic_string()))
+			if(probeFileWithReader(*reader, filereader, probe))
+			{
+				probedBy = reader;
+				return probe;
+			}
+
+		for(OctFileReader* reader : readersForHeader(filereader))
+			if(probeFileWithReader(*reader, filereader, probe))
+			{
+				probedBy = reader;
+				return probe;
+			}
+
+		return probe;
+	}
+
 // used by friend class OctFileReader
 	void OctFileRead::registerFileRead(OctFileReader* reader)
 	{
@@ -140,8 +510,13 @@ namespace OctData
 		{
 			BOOST_LOG_TRIVIAL(info) << "OctData: register reader for " << ext.name;
 			extensions.push_back(ext);
+			for(const std::string& suffix : ext.getExtensionsLowerCase())
+				suffixTable.emplace_back(suffix, reader);
 		}
 
+		for(const FileSignature& signature : reader->getSignatures())
+			signatureHeaderSize = std::max(signatureHeaderSize, signature.offset + signature.magic.size());
+
 		fileReaders.push_back(reader);
 	}
 
@@ -152,9 +527,10 @@ namespace OctData
 
 	bool OctFileRead::isLoadable(const std::string& filename)
 	{
+		const std::string lowerCaseName = OctExtension::toLower(filename);
 
-		for(const OctExtension& supportedExtension : getInstance().extensions)
-			if(supportedExtension.matchWithFile(filename))
+		for(const std::pair<std::string, OctFileReader*>& suffix : getInstance().suffixTable)
+			if(OctExtension::matchSuffix(lowerCaseName, suffix.first))
 				return true;
 		return false;
 	}
@@ -19,6 +19,8 @@
 
 #include <vector>
 #include <string>
+#include <functional>
+#include <memory>
 
 #include "octextension.h"
 
@@ -40,11 +42,16 @@ namespace OctData
 	class FileWriteOptions;
 	class OctExtensionsList;
 	class FileReader;
+	class FileProbe;
 
 	class OctFileRead
 	{
 		friend class OctFileReader;
 	public:
+		// called for every file of openFiles, also for files that could not be read (empty OCT)
+		// the calls are serialized, returning false stops opening further files
+		typedef std::function<bool(const boost::filesystem::path& file, OCT& oct)> FileOpenedCallback;
+
 		Octdata_EXPORTS static OctFileRead& getInstance()                        { static OctFileRead instance; return instance; }
 
 		Octdata_EXPORTS static const OctExtensionsList& supportedExtensions();
@@ -52,6 +59,27 @@ namespace OctData
 		Octdata_EXPORTS static OCT openFile(const boost::filesystem::path& filename, const FileReadOptions& op, CppFW::Callback* callback = nullptr);
 		Octdata_EXPORTS static OCT openFile(const std::string& filename, CppFW::Callback* callback = nullptr);
 
+		// read only OCT for sharing between threads (see OCTSnapshot)
+		Octdata_EXPORTS static std::shared_ptr<const OCT> openSnapshot(const boost::filesystem::path& filename, const FileReadOptions& op, CppFW::Callback* callback = nullptr);
+
+		// opens the files with up to concurrency files at the same time (<= 0: one per hardware thread)
+		// memoryBudgetMB limits the summed memory estimate of the files in progress (0: no limit),
+		// files without an estimate reserve their size on disk, a lower bound for compressed formats,
+		// the memory of a file is released when fileOpened returns
+		// returns the number of successfully read files, an exception of a reader or of fileOpened stops opening
+		// further files and is rethrown after the files in progress are finished
+		Octdata_EXPORTS static std::size_t openFiles(const std::vector<boost::filesystem::path>& files
+		                                           , const FileReadOptions& op
+		                                           , const FileOpenedCallback& fileOpened
+		                                           , int concurrency = 0
+		                                           , std::size_t memoryBudgetMB = 0);
+
+		// metadata summary from the file headers without decoding pixel data,
+		// empty if the file can't be read or its format has no header probe (supported: vol, E2E/sdb, xml, Cirrus raw, gipl),
+		// E2E/sdb gives only the patient id, the B-scan count and the image sizes (laterality, scan pattern, dates and UIDs stay unset)
+		Octdata_EXPORTS static FileProbe probe(const std::string& filename);
+		Octdata_EXPORTS static FileProbe probe(const boost::filesystem::path& filename);
+
 		Octdata_EXPORTS static bool isLoadable(const std::string& filename);
 
 		Octdata_EXPORTS static bool writeFile(const std::string& filename, const OCT& octdata);
@@ -65,15 +93,29 @@ namespace OctData
 		void registerFileRead(OctFileReader* reader);
 		OCT openFilePrivat(const std::string& filename, const FileReadOptions& op, CppFW::Callback* callback);
 		OCT openFilePrivat(const boost::filesystem::path& file, const FileReadOptions& op, CppFW::Callback* callback);
+		bool applyMemoryBudget(const boost::filesystem::path& file, FileReadOptions& op);
+		// memory estimate from the header probe, 0 if unknown (no probe or no image sizes)
+		std::size_t estimateFileMemory(const boost::filesystem::path& file, const FileReadOptions& op, bool* lazyReader = nullptr);
+		std::size_t openFilesPrivat(const std::vector<boost::filesystem::path>& files, const FileReadOptions& op, const FileOpenedCallback& fileOpened, int concurrency, std::size_t memoryBudgetMB);
+
+		FileProbe probePrivat(const boost::filesystem::path& file);
+		FileProbe probePrivat(const boost::filesystem::path& file, const OctFileReader*& probedBy);
+		bool probeFileWithReader(OctFileReader& reader, FileReader& filereader, FileProbe& probe);
 
 		bool writeFilePrivat(const boost::filesystem::path& filepath, const OCT& octdata, const FileWriteOptions& opt);
 
+		std::vector<OctFileReader*> readersForExtension(const std::string& filename) const;
+		std::vector<OctFileReader*> readersForHeader(FileReader& filereader) const;
+
 		bool openFileFromExt(OCT& oct, FileReader& filename, const FileReadOptions& op, CppFW::Callback* callback);
 		bool tryOpenFile(OCT& oct, FileReader& filename, const FileReadOptions& op, CppFW::Callback* callback);
 
 		OctExtensionsList extensions;
 
 		std::vector<OctFileReader*> fileReaders;
+
+		std::vector<std::pair<std::string, OctFileReader*>> suffixTable; // lower case extensions in registration order
+		std::size_t signatureHeaderSize = 0;                              // file header bytes to match all signatures
 	};
 	
 }